@@ -62,7 +62,9 @@
  *           This application runs Glossy periodically to flood a packet from one node (initiator)
  *           to the other nodes (receivers) and prints flooding-related statistics.
  *
- *           The application schedules Glossy periodically with a fixed period \link GLOSSY_PERIOD \endlink.
+ *           The application schedules Glossy periodically. The initiator picks the period
+ *           between \link GLOSSY_PERIOD_MIN \endlink and \link GLOSSY_PERIOD_MAX \endlink
+ *           from the backlog of its queue and announces it to the receivers.
  *
  *           The duration of each Glossy phase is given by \link GLOSSY_DURATION \endlink.
  *
@@ -93,6 +95,10 @@
  */
 
 #include "glossy-test-hda.h"
+#include "dev/glossy-stats.h"
+#include "dev/glossy-telemetry.h"
+#include "dev/uart1.h"
+#include <string.h>
 
 /**
  * \defgroup glossy-test-variables Application variables
@@ -104,20 +110,37 @@
  * @{
  */
 
-glossy_data_struct glossy_data; /**< \brief Flooding data. */
+static uint8_t batch_buf[GLOSSY_PIPELINE_PKTS * BATCH_LEN_MAX]; /**< \brief Flooding data: batches of records,
+ one per pipelined packet. */
+glossy_data_struct glossy_data[GLOSSY_PIPELINE_PKTS * BATCH_RECORDS_MAX]; /**< \brief Records unpacked from
+ the batches of the last Glossy phase. */
+static uint8_t n_records = 0; /**< \brief Number of records in \link glossy_data \endlink. */
+static uint8_t batch_pkts = 0; /**< \brief Number of batches packed in \link batch_buf \endlink
+ for the next Glossy phase (initiator), zero until they are packed. */
+static uint8_t batch_len = 0; /**< \brief Length of each packed batch. */
+static uint8_t batch_level = GLOSSY_PERIOD_LEVELS - 1; /**< \brief Period level announced
+ in the packed batches. */
+static uint8_t sync_batch[BATCH_HDR_LEN]; /**< \brief Empty batch flooded instead when the next
+ batches were not packed in time. */
+static uint8_t *flood_buf = batch_buf; /**< \brief Buffer flooded during the last Glossy phase. */
 static struct rtimer rt; /**< \brief Rtimer used to schedule Glossy. */
 static struct etimer et_traffic, et_traffic_period;
+static struct etimer et_start; /**< \brief Event timer to pack the batches of the first phase. */
 static struct pt pt; /**< \brief Protothread used to schedule Glossy. */
-static rtimer_clock_t t_ref_l_old = 0; /**< \brief Reference time computed from the Glossy
+static rtimer_long_clock_t t_ref_l_old = 0; /**< \brief Reference time computed from the Glossy
  phase before the last one. \sa get_t_ref_l */
-static uint8_t skew_estimated = 0; /**< \brief Not zero if the clock skew over a period of length
- \link GLOSSY_PERIOD \endlink has already been estimated. */
+static uint8_t skew_estimated = 0; /**< \brief Not zero if the clock skew over a period
+ has already been estimated. */
 static uint8_t sync_missed = 0; /**< \brief Current number of consecutive phases without
  synchronization (reference time not computed). */
-static rtimer_clock_t t_start = 0; /**< \brief Starting time (low-frequency clock)
+static rtimer_long_clock_t t_start = 0; /**< \brief Starting time (low-frequency clock)
  of the last Glossy phase. */
 static int period_skew = 0; /**< \brief Current estimation of clock skew over a period
- of length \link GLOSSY_PERIOD \endlink. */
+ of length \link GLOSSY_PERIOD_MAX \endlink. */
+static uint8_t period_level = GLOSSY_PERIOD_LEVELS - 1; /**< \brief Level of the period
+ until the next Glossy phase. */
+static uint8_t period_level_last = GLOSSY_PERIOD_LEVELS - 1; /**< \brief Level of the period
+ that ended with the last Glossy phase. */
 
 static rtimer_clock_t t_start_queue = 0;
 
@@ -130,13 +153,16 @@ glossy_data_struct random_traffic_data;
  * @{
  */
 
-static unsigned long packets_received = 0; /**< \brief Current number of received packets. */
-static unsigned long packets_missed = 0; /**< \brief Current number of missed packets. */
+static unsigned long records_received = 0; /**< \brief Current number of received queue records. */
+#if !TELEMETRY
 static unsigned long latency = 0; /**< \brief Latency of last Glossy phase, in us. */
-static unsigned long sum_latency = 0; /**< \brief Current sum of latencies, in ticks of low-frequency
- clock (used to compute average). */
+#endif /* !TELEMETRY */
+static unsigned int phases_since_print = 0; /**< \brief Glossy phases since statistics were last printed. */
 
-queueCDT myQueue;
+static glossy_data_struct queue_buf[QUEUE_SIZE];
+/** \brief Traffic queue: filled by random_traffic_process, drained by
+ glossy_print_stats_process when it packs the batches of the next phase. */
+static struct spscring queue;
 
 unsigned int traffic_period = 4;
 unsigned int k = 0;
@@ -159,79 +185,101 @@ int seg_no = 0;
 
 PROCESS(glossy_test, "Glossy test");
 PROCESS(glossy_print_stats_process, "Glossy print stats");
+PROCESS(glossy_print_summary_process, "Glossy print summary");
 PROCESS(queue_init, "Glossy init queue");
-PROCESS(random_traffic_process, "Glossy init queue");
-PROCESS(set_traffic_period, "Glossy init queue");
+PROCESS(random_traffic_process, "Glossy traffic");
+PROCESS(set_traffic_period, "Glossy traffic period");
 
 AUTOSTART_PROCESSES(&glossy_test);
 
-////////////////////////////////////////
-///		QUEUE FUNCTIONS//////////////////////
-/////////////////////////////////////
+///////////////////////////////////////////////////////
+/////			BATCHING			//////////////////
+//////////////////////////////////////////////////////
 
-void print_queue_Stats(queueCDT* queueADT, char functionName[50]) {
-	printf("[QUEUE] print stats from Function: %s\n", functionName);
-	printf("[QUEUE] count: %u\n", queueADT->count);
-	printf("[QUEUE] front: %u\n", queueADT->front);
-	printf("[QUEUE] rear: %u\n", queueADT->rear);
+/**
+ * Pack up to GLOSSY_PIPELINE_PKTS * BATCH_RECORDS_MAX queued records
+ * into batches of equal length, one per pipelined packet, each announcing
+ * period level \p level.
+ * An empty queue gives one empty batch, still flooded for synchronization.
+ * Returns the number of batches and stores the length of each batch in *len.
+ */
+uint8_t pack_batches(struct spscring *q, uint8_t *buf, uint8_t *len, uint8_t level) {
+	uint8_t total = spscring_elements(q);
+	uint8_t n_pkts, per_pkt, i;
+
+	if (total > GLOSSY_PIPELINE_PKTS * BATCH_RECORDS_MAX)
+		total = GLOSSY_PIPELINE_PKTS * BATCH_RECORDS_MAX;
+	// all packets of a stream have the same length: spread the records evenly
+	n_pkts = total ? (total + BATCH_RECORDS_MAX - 1) / BATCH_RECORDS_MAX : 1;
+	per_pkt = (total + n_pkts - 1) / n_pkts;
+	*len = BATCH_LEN(per_pkt);
+
+	for (i = 0; i < n_pkts; i++, buf += *len) {
+		// records are packed back to back after the batch header
+		buf[0] = spscring_get_bulk(q, &buf[BATCH_HDR_LEN], per_pkt);
+		buf[1] = level;
+	}
+	return n_pkts;
 }
 
-void QueueInit(queueCDT* queueADT) {
-	int i = 0;
-	queueADT->rear = 0;
-	queueADT->front = 0;
-	queueADT->count = 0;
-	for (i = 0; i < MAX_QUEUE_SIZE; i++)
-		queueADT->glossy_data[i].seq_no = -1;
-
-	print_queue_Stats(queueADT, "Queue Init");
+/**
+ * Unpack the batches received during the last Glossy phase into records.
+ * Returns the number of records.
+ */
+uint8_t unpack_batches(const uint8_t *buf, uint8_t len, uint8_t mask,
+		glossy_data_struct *records) {
+	uint8_t n = 0, j;
+
+	for (; mask; mask >>= 1, buf += len) {
+		if ((mask & 1) && buf[0] <= BATCH_RECORDS_MAX && BATCH_LEN(buf[0]) <= len) {
+			for (j = 0; j < buf[0]; j++) {
+				memcpy(&records[n++], &buf[BATCH_LEN(j)], DATA_LEN);
+			}
+		}
+	}
+	return n;
 }
 
-void Enqueue(queueCDT* queueADT, glossy_data_struct data) {
-
-	queueADT->glossy_data[queueADT->rear] = data;
-	if (queueADT->count + 1 <= MAX_QUEUE_SIZE)
-		queueADT->count++;
-
-	if (queueADT->rear + 1 > MAX_QUEUE_SIZE - 1) {
-		queueADT->rear = 0;
-	} else
-		queueADT->rear++;
+/**
+ * Period level for the next phase, from the backlog of the queue:
+ * the period halves each time the backlog doubles, starting from
+ * the longest period when less than 1/2^(GLOSSY_PERIOD_LEVELS - 1)
+ * of the records that fit in a phase are queued.
+ */
+uint8_t select_period_level(uint8_t backlog) {
+	uint8_t level = 0;
+	unsigned int threshold = GLOSSY_PIPELINE_PKTS * BATCH_RECORDS_MAX / 2;
 
-	if (queueADT->count >= MAX_QUEUE_SIZE) {
-		if (queueADT->front + 1 > MAX_QUEUE_SIZE - 1) {
-			queueADT->front = 0;
-		} else
-			queueADT->front++;
+	while (level < GLOSSY_PERIOD_LEVELS - 1 && backlog < threshold) {
+		level++;
+		threshold /= 2;
 	}
-	print_queue_Stats(queueADT, "EnQueue");
+	return level;
 }
 
-void Dequeue(queueCDT* queueADT) {
-	//queueADT->count--;
-
-	print_queue_Stats(queueADT, "DeQueue");
+/**
+ * Pack the queued records for the next Glossy phase of the initiator.
+ * Called from process context after the previous phase, so that the
+ * rtimer interrupt that starts the phase only has to hand the batches
+ * to Glossy.
+ */
+static void prepare_batches(void) {
+	batch_level = select_period_level(spscring_elements(&queue));
+	batch_pkts = pack_batches(&queue, batch_buf, &batch_len, batch_level);
 }
 
-glossy_data_struct getGlossyData(queueCDT* queueADT) {
-	glossy_data_struct returnData;
-//	print_queue_Stats(queueADT, "GetGlossyData");
-	returnData = queueADT->glossy_data[queueADT->front];
-	if (queueADT->count > 0) {
-		queueADT->count--;
-		if(queueADT->front + 1 > MAX_QUEUE_SIZE - 1)
-			queueADT->front = 0;
-			else
-		queueADT->front++;
+/**
+ * Period level announced in the first batch received during the last
+ * Glossy phase, or the shortest period if nothing valid was received
+ * (the initiator may have changed period meanwhile).
+ */
+uint8_t announced_period_level(const uint8_t *buf, uint8_t len, uint8_t mask) {
+	for (; mask; mask >>= 1, buf += len) {
+		if ((mask & 1) && len >= BATCH_HDR_LEN && buf[1] < GLOSSY_PERIOD_LEVELS) {
+			return buf[1];
+		}
 	}
-//
-//	print_queue_Stats(queueADT, "GetGlossyData");
-	return returnData;
-}
-
-int get_count(queueCDT* queueADT) {
-	print_queue_Stats(queueADT, "getCount");
-	return queueADT->count;
+	return 0;
 }
 
 ///////////////////////////////////////////////////////
@@ -247,59 +295,102 @@ PROCESS_THREAD(glossy_print_stats_process, ev, data) {
 			// Print statistics only if Glossy is not still bootstrapping.
 			if (!GLOSSY_IS_BOOTSTRAPPING()) {
 				if (get_rx_cnt()) {	// Packet received at least once.
-									// Increment number of successfully received packets.
-					packets_received++;
+					// Unpack the records received during the last Glossy phase.
+					n_records = unpack_batches(flood_buf, get_data_len(),
+							get_seq_mask(), glossy_data);
+					records_received += n_records;
 					// Compute latency during last Glossy phase.
 					rtimer_clock_t lat = get_t_first_rx_l() - get_t_ref_l();
-					// Add last latency to sum of latencies.
-					sum_latency += lat;
+					// Add it to the statistics.
+					glossy_stats_update(1, lat);
+#if TELEMETRY
+					// Send the telemetry record of the last Glossy phase
+					// (no seq_no if only empty batches were flooded, for synchronization).
+					glossy_telemetry_send(n_records ? glossy_data[0].seq_no : GLOSSY_TELEMETRY_MISSED, lat);
+#else /* TELEMETRY */
 					// Convert latency to microseconds.
-					latency = (unsigned long) (lat) * 1e6 / RTIMER_SECOND;
+					latency = GLOSSY_STATS_TICKS_TO_US(lat);
 					// Print information about last packet and related latency.
-					printf(
-							"Glossy received %u time%s: seq_no %lu, latency %lu.%03lu ms\n",
+					printf("Glossy received %u time%s: %u record%s",
 							get_rx_cnt(), (get_rx_cnt() > 1) ? "s" : "",
-							glossy_data.seq_no, latency / 1000, latency % 1000);
+							n_records, (n_records == 1) ? "" : "s");
+					if (n_records) {
+						printf(", seq_no %lu", glossy_data[0].seq_no);
+					}
+					printf(", latency %lu.%03lu ms\n", latency / 1000, latency % 1000);
+#endif /* TELEMETRY */
 				} else {	// Packet not received.
-							// Increment number of missed packets.
-					packets_missed++;
+							// Count the missed packet.
+					glossy_stats_update(0, 0);
+#if TELEMETRY
+					// Send the telemetry record of the last Glossy phase.
+					glossy_telemetry_send(GLOSSY_TELEMETRY_MISSED, 0);
+#else /* TELEMETRY */
 					// Print failed reception.
 					printf("Glossy NOT received\n");
+#endif /* TELEMETRY */
+				}
+				// Print the accumulated statistics every STATS_PRINT_PHASES phases.
+				if (++phases_since_print == STATS_PRINT_PHASES) {
+					phases_since_print = 0;
+					process_poll(&glossy_print_summary_process);
 				}
+			}
+			// Pack the records for the next phase, unless the batches
+			// packed for the last one are still waiting to be flooded.
+			if (IS_INITIATOR() && !batch_pkts) {
+				prepare_batches();
+			}
+		}
+
+	PROCESS_END();
+}
+
+// Bulk logging, at normal priority so that it never delays the handling of a phase.
+PROCESS_THREAD(glossy_print_summary_process, ev, data) {
+	PROCESS_BEGIN()
+		;
+
+		while (1) {
+			PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+			// Radio-on time is reported per second, since the period varies.
+			glossy_stats_print(RTIMER_SECOND);
 #if GLOSSY_DEBUG
-//			printf("skew %ld ppm\n", (long)(period_skew * 1e6) / GLOSSY_PERIOD);
-				printf(
-						"high_T_irq %u, rx_timeout %u, bad_length %u, bad_header %u, bad_crc %u\n",
-						high_T_irq, rx_timeout, bad_length, bad_header,
-						bad_crc);
+			printf(
+					"high_T_irq %u, rx_timeout %u, bad_length %u, bad_header %u, bad_crc %u\n",
+					high_T_irq, rx_timeout, bad_length, bad_header,
+					bad_crc);
 #endif /* GLOSSY_DEBUG */
-				// Compute current average reliability.
-				unsigned long avg_rel = packets_received * 1e5
-						/ (packets_received + packets_missed);
-				// Print information about average reliability.
-				printf("average reliability %3lu.%03lu %% ", avg_rel / 1000,
-						avg_rel % 1000);
-				printf("(missed %lu out of %lu packets)\n", packets_missed,
-						packets_received + packets_missed);
-#if ENERGEST_CONF_ON
-				// Compute average radio-on time, in microseconds.
-				unsigned long avg_radio_on = (unsigned long) GLOSSY_PERIOD * 1e6
-						/ RTIMER_SECOND
-						* (energest_type_time(ENERGEST_TYPE_LISTEN)
-								+ energest_type_time(ENERGEST_TYPE_TRANSMIT))
-						/ (energest_type_time(ENERGEST_TYPE_CPU)
-								+ energest_type_time(ENERGEST_TYPE_LPM));
-				// Print information about average radio-on time.
-				printf("average radio-on time %lu.%03lu ms\n",
-						avg_radio_on / 1000, avg_radio_on % 1000);
-#endif /* ENERGEST_CONF_ON */
-				// Compute average latency, in microseconds.
-				unsigned long avg_latency = sum_latency * 1e6
-						/ (RTIMER_SECOND * packets_received);
-				// Print information about average latency.
-				printf("average latency %lu.%03lu ms\n", avg_latency / 1000,
-						avg_latency % 1000);
+			// Print the number of log bytes dropped because the UART was busy.
+			printf("uart1 dropped %lu bytes\n", uart1_tx_dropped());
+			// Print the use of the event queue.
+			printf("events max %u, full %u, coalesced %u\n", process_maxevents,
+					process_fullevents, process_coalesced);
+#if PROCESS_PROFILE
+			// Report the CPU time used by each process so far.
+#if TELEMETRY
+			glossy_telemetry_send_profile();
+#else /* TELEMETRY */
+			process_profile_print();
+#endif /* TELEMETRY */
+#endif /* PROCESS_PROFILE */
+#if MSP430_STACK_PAINT
+			// Report the stack high-watermark and the heap size.
+#if TELEMETRY
+			glossy_telemetry_send_memory();
+#else /* TELEMETRY */
+			printf("stack max %u, margin %u, heap %u\n", msp430_stack_max(),
+					msp430_stack_margin(), msp430_heap_used());
+#endif /* TELEMETRY */
+#endif /* MSP430_STACK_PAINT */
+			// Print the number of records received so far and the current period.
+			printf("records received %lu, period %u ms", records_received,
+					(unsigned int)(((unsigned long)GLOSSY_PERIOD(period_level) * 1000 + RTIMER_SECOND / 2) / RTIMER_SECOND));
+			if (IS_INITIATOR()) {
+				printf(", queue %u, overflows %u", spscring_elements(&queue),
+						queue.overflows);
 			}
+			printf("\n");
 		}
 
 	PROCESS_END();
@@ -309,10 +400,8 @@ PROCESS_THREAD(queue_init, ev, data) {
 
 PROCESS_BEGIN()
 	;
-	printf("[create queue]: create queue\n");
 	if (IS_INITIATOR()) {
-		QueueInit(&myQueue);
-
+		spscring_init(&queue, queue_buf, DATA_LEN, QUEUE_SIZE);
 	}
 
 PROCESS_END();
@@ -373,10 +462,8 @@ if ( IS_INITIATOR())
 	if (ev == PROCESS_EVENT_TIMER) {
 		random_traffic_data.seq_no = seg_no++;
 		random_traffic_data.timestamp = RTIMER_NOW();
-		printf("[QUEUE]: Add data to Queue with Seq: %d\n",
-				random_traffic_data.seq_no);
-		printf("[QUEUE]: Current traffic period is: %d\n\n", traffic_period);
-		Enqueue(&myQueue, random_traffic_data);
+		// a full queue drops the record and counts the overflow
+		spscring_put(&queue, &random_traffic_data);
 
 		switch (traffic_period) {
 		case 0:
@@ -434,10 +521,12 @@ PROCESS_END()
 static inline void estimate_period_skew(void) {
 // Estimate clock skew over a period only if the reference time has been updated.
 if (GLOSSY_IS_SYNCED()) {
-// Estimate clock skew based on previous reference time and the Glossy period.
-period_skew = get_t_ref_l() - (t_ref_l_old + (rtimer_clock_t) GLOSSY_PERIOD);
+// Estimate clock skew based on previous reference time and the Glossy period that has elapsed,
+// scaled to GLOSSY_PERIOD_MAX so that it can be applied to any period.
+period_skew = (short)(GLOSSY_REFERENCE_TIME - (t_ref_l_old + GLOSSY_PERIOD(period_level_last)))
+		* (1 << (GLOSSY_PERIOD_LEVELS - 1 - period_level_last));
 			// Update old reference time with the newer one.
-t_ref_l_old = get_t_ref_l();
+t_ref_l_old = GLOSSY_REFERENCE_TIME;
 // If Glossy is still bootstrapping, count the number of consecutive updates of the reference time.
 if (GLOSSY_IS_BOOTSTRAPPING()) {
 // Increment number of consecutive updates of the reference time.
@@ -460,8 +549,26 @@ bad_header = 0;
 }
 }
 
+/**
+ * \brief Clock skew over a period at level \p l.
+ */
+#define PERIOD_SKEW(l) (period_skew / (1 << (GLOSSY_PERIOD_LEVELS - 1 - (l))))
+
 /** @} */
 
+char glossy_scheduler(struct rtimer *t, void *ptr);
+
+/**
+ * \brief Schedule the next Glossy phase at \p time, or whole periods later if
+ *        \p time has already passed (e.g., after a long pipelined phase).
+ */
+static void schedule_phase(struct rtimer *t, rtimer_long_clock_t time,
+		rtimer_long_clock_t period, void *ptr) {
+while (rtimer_set_long(t, time, 1, (rtimer_callback_t) glossy_scheduler, ptr) == RTIMER_ERR_TIME) {
+	time += period;
+}
+}
+
 void packet_queue(struct rtimer *t, void *ptr) {
 
 if ( IS_INITIATOR())
@@ -480,18 +587,30 @@ PT_BEGIN(&pt)
 
 if (IS_INITIATOR()) {	// Glossy initiator.
 while (1) {
-	// Increment sequence number.
-glossy_data = getGlossyData(&myQueue);
-//printf("[SCHEDULER]: Get Data from queue seq.np: %u\n",glossy_data.seq_no);
+	// Flood the batches packed after the last phase; if they are not
+	// ready yet, flood an empty batch to keep the receivers synchronized.
+uint8_t n_pkts = 1, len = BATCH_HDR_LEN;
+period_level_last = period_level;
+if (batch_pkts) {
+	flood_buf = batch_buf;
+	n_pkts = batch_pkts;
+	len = batch_len;
+	period_level = batch_level;
+	batch_pkts = 0;
+} else {
+	flood_buf = sync_batch;
+	sync_batch[0] = 0;
+	sync_batch[1] = period_level;
+}
 	// Glossy phase.
 leds_on(LEDS_GREEN);
 rtimer_clock_t t_stop = RTIMER_TIME(t) + GLOSSY_DURATION;
-//	// Start Glossy.
-glossy_start((glossy_data_struct *)&glossy_data, DATA_LEN, GLOSSY_INITIATOR, GLOSSY_SYNC,
+//	// Start Glossy: flood the batches back-to-back.
+glossy_start_pipeline((glossy_data_struct *)flood_buf, len, n_pkts, GLOSSY_INITIATOR, GLOSSY_SYNC,
 	N_TX,
 	APPLICATION_HEADER, t_stop, (rtimer_callback_t) glossy_scheduler, t, ptr);
 	// Store time at which Glossy has started.
-t_start = RTIMER_TIME(t);
+t_start = RTIMER_TIME_LONG(t);
 //	// Yield the protothread. It will be resumed when Glossy terminates.
 PT_YIELD(&pt);
 
@@ -502,17 +621,13 @@ glossy_stop();
 if (!GLOSSY_IS_BOOTSTRAPPING()) {
 // Glossy has already successfully bootstrapped.
 if (!GLOSSY_IS_SYNCED()) {
-	// The reference time was not updated: increment reference time by GLOSSY_PERIOD.
-	set_t_ref_l(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD);
+	// The reference time was not updated: increment reference time by the elapsed period.
+	set_t_ref_l_long(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD(period_level_last));
 	set_t_ref_l_updated(1);
 }
 }
-	//	printf("[SCHEDULER]: tstart  %d\n",t_start);
-	//printf("[SCHEDULER]: glossy period %d\n",(int)GLOSSY_PERIOD);
-//			printf("[SCHEDULER]: Set Timer to %d\n",t_start + GLOSSY_PERIOD);
-// Schedule begin of next Glossy phase based on GLOSSY_PERIOD.
-rtimer_set(t, t_start + GLOSSY_PERIOD, 1, (rtimer_callback_t) glossy_scheduler,
-	ptr);
+// Schedule begin of next Glossy phase based on the announced period.
+schedule_phase(t, t_start + GLOSSY_PERIOD(period_level), GLOSSY_PERIOD(period_level), ptr);
 			// Estimate the clock skew over the last period.
 estimate_period_skew();
 // Poll the process that prints statistics (will be activated later by Contiki).
@@ -535,7 +650,8 @@ t_stop = RTIMER_TIME(t) + GLOSSY_INIT_DURATION;
 t_stop = RTIMER_TIME(t) + GLOSSY_DURATION;
 }
 				// Start Glossy.
-glossy_start((uint8_t *) &glossy_data, DATA_LEN, GLOSSY_RECEIVER, GLOSSY_SYNC,
+// The batch length is learned from the first packet received.
+glossy_start_pipeline((glossy_data_struct *)batch_buf, 0, GLOSSY_PIPELINE_PKTS, GLOSSY_RECEIVER, GLOSSY_SYNC,
 	N_TX,
 	APPLICATION_HEADER, t_stop, (rtimer_callback_t) glossy_scheduler, t, ptr);
 			// Yield the protothread. It will be resumed when Glossy terminates.
@@ -545,6 +661,10 @@ PT_YIELD(&pt);
 leds_off(LEDS_GREEN);
 				// Stop Glossy.
 glossy_stop();
+// Adopt the period announced by the initiator (the shortest one if nothing was received).
+period_level_last = period_level;
+period_level = get_rx_cnt() ?
+		announced_period_level(batch_buf, get_data_len(), get_seq_mask()) : 0;
 if (GLOSSY_IS_BOOTSTRAPPING()) {
 // Glossy is still bootstrapping.
 if (!GLOSSY_IS_SYNCED()) {
@@ -555,8 +675,9 @@ if (!GLOSSY_IS_SYNCED()) {
 // Glossy has already successfully bootstrapped.
 if (!GLOSSY_IS_SYNCED()) {
 	// The reference time was not updated:
-	// increment reference time by GLOSSY_PERIOD + period_skew.
-	set_t_ref_l(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD + period_skew);
+	// increment reference time by the elapsed period + period_skew.
+	set_t_ref_l_long(GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD(period_level_last)
+			+ PERIOD_SKEW(period_level_last));
 	set_t_ref_l_updated(1);
 	// Increment sync_missed.
 	sync_missed++;
@@ -572,22 +693,18 @@ if (GLOSSY_IS_BOOTSTRAPPING()) {
 if (skew_estimated == 0) {
 	// The reference time was not updated:
 	// Schedule begin of next Glossy phase based on last begin and GLOSSY_INIT_PERIOD.
-	rtimer_set(t, RTIMER_TIME(t) + GLOSSY_INIT_PERIOD, 1,
-			(rtimer_callback_t) glossy_scheduler, ptr);
+	schedule_phase(t, RTIMER_TIME_LONG(t) + GLOSSY_INIT_PERIOD, GLOSSY_INIT_PERIOD, ptr);
 } else {
 	// The reference time was updated:
-	// Schedule begin of next Glossy phase based on reference time and GLOSSY_INIT_PERIOD.
-	rtimer_set(t,
-			GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD - GLOSSY_INIT_GUARD_TIME, 1,
-			(rtimer_callback_t) glossy_scheduler, ptr);
+	// Schedule begin of next Glossy phase based on reference time and the announced period.
+	schedule_phase(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD(period_level) - GLOSSY_INIT_GUARD_TIME,
+			GLOSSY_PERIOD(period_level), ptr);
 }
 } else {
 // Glossy has already successfully bootstrapped:
-// Schedule begin of next Glossy phase based on reference time and GLOSSY_PERIOD.
-rtimer_set(t,
-		GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD + period_skew
-				- GLOSSY_GUARD_TIME * (1 + sync_missed), 1,
-		(rtimer_callback_t) glossy_scheduler, ptr);
+// Schedule begin of next Glossy phase based on reference time and the announced period.
+schedule_phase(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD(period_level) + PERIOD_SKEW(period_level)
+				- GLOSSY_GUARD_TIME * (1 + sync_missed), GLOSSY_PERIOD(period_level), ptr);
 }
 // Poll the process that prints statistics (will be activated later by Contiki).
 process_poll(&glossy_print_stats_process);
@@ -779,18 +896,34 @@ PROCESS_BEGIN()
 
 leds_on(LEDS_RED);
 // Initialize Glossy data.
-glossy_data.seq_no = 0;
-// Start print stats processes.
+glossy_data[0].seq_no = 0;
+// Reset statistics and start print stats processes.
+glossy_stats_init();
+// The outcome of each phase is handled ahead of logging and traffic.
+process_set_priority(&glossy_print_stats_process, PROCESS_PRIO_HIGH);
 process_start(&glossy_print_stats_process, NULL);
+process_start(&glossy_print_summary_process, NULL);
 // Start Glossy busy-waiting process.
 process_start(&glossy_process, NULL);
+#if GLOSSY_CALIBRATE_IRQ
+if (get_irq_delay() != GLOSSY_IRQ_DELAY) {
+	printf("**** Glossy IRQ delay %u, expected %u: update GLOSSY_CONF_IRQ_DELAY\n",
+			get_irq_delay(), GLOSSY_IRQ_DELAY);
+}
+#endif /* GLOSSY_CALIBRATE_IRQ */
 process_start(&queue_init, NULL);
 process_start(&set_traffic_period, NULL);
 process_start(&random_traffic_process, NULL);
 
 printf("Start glossy scheduler\n");
-rtimer_set(&rt, RTIMER_NOW() + RTIMER_SECOND * 10, 1,
+rtimer_set_long(&rt, RTIMER_NOW_LONG() + RTIMER_SECOND * 10UL, 1,
 (rtimer_callback_t) glossy_scheduler, NULL);
+if (IS_INITIATOR()) {
+	// Pack the records queued meanwhile shortly before the first phase.
+	etimer_set(&et_start, CLOCK_SECOND * 10 - CLOCK_SECOND / 8);
+	PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et_start));
+	prepare_batches();
+}
 
 PROCESS_END();
 }
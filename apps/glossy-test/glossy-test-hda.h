@@ -40,7 +40,8 @@
  *         A simple example of an application that uses Glossy, header file.
  *
  *         The application schedules Glossy periodically.
- *         The period is determined by \link GLOSSY_PERIOD \endlink.
+ *         The period is chosen by the initiator between \link GLOSSY_PERIOD_MIN \endlink
+ *         and \link GLOSSY_PERIOD_MAX \endlink.
  * \author
  *         Federico Ferrari <ferrari@tik.ee.ethz.ch>
  */
@@ -50,6 +51,7 @@
 
 #include "glossy.h"
 #include "node-id.h"
+#include "lib/spscring.h"
 
 /**
  * \defgroup glossy-test-settings Application settings
@@ -75,16 +77,46 @@
 #define N_TX                    5
 
 /**
- * \brief Period with which a Glossy phase is scheduled.
- *        Default value: 250 ms.
+ * \brief Shortest period with which a Glossy phase is scheduled (under backlog).
+ *        Default value: 200 ms.
  */
-#define GLOSSY_PERIOD           (RTIMER_SECOND / 4)      // 500 ms
+#define GLOSSY_PERIOD_MIN       (RTIMER_SECOND / 5)      // 200 ms
+
+/**
+ * \brief Number of period levels. The period at level l is GLOSSY_PERIOD_MIN << l.
+ *        The initiator picks the level from the backlog of its queue and announces it
+ *        in each batch; receivers adopt it for the next phase.
+ *        Default value: 5 (200 ms to 3.2 s).
+ */
+#define GLOSSY_PERIOD_LEVELS    5
+
+/**
+ * \brief Period at level \p l.
+ */
+#define GLOSSY_PERIOD(l)        ((rtimer_long_clock_t)GLOSSY_PERIOD_MIN << (l))
+
+/**
+ * \brief Longest period, used when the queue is idle.
+ */
+#define GLOSSY_PERIOD_MAX       GLOSSY_PERIOD(GLOSSY_PERIOD_LEVELS - 1)
+
+/**
+ * \brief Maximum number of batches of queued records flooded back-to-back in each Glossy phase.
+ *        Default value: 2.
+ */
+#define GLOSSY_PIPELINE_PKTS    2
+
+/**
+ * \brief Additional duration of a Glossy phase for each pipelined batch (full-size packet).
+ *        Default value: 50 ms.
+ */
+#define GLOSSY_PKT_DURATION     (RTIMER_SECOND / 20)     //  50 ms
 
 /**
  * \brief Duration of each Glossy phase.
- *        Default value: 20 ms.
+ *        Default value: 120 ms.
  */
-#define GLOSSY_DURATION         (RTIMER_SECOND / 50)     //  20 ms
+#define GLOSSY_DURATION         (RTIMER_SECOND / 50 + GLOSSY_PIPELINE_PKTS * GLOSSY_PKT_DURATION) // 120 ms
 
 /**
  * \brief Guard-time at receivers.
@@ -102,9 +134,22 @@
  */
 #define GLOSSY_BOOTSTRAP_PERIODS 3
 
+/**
+ * \brief Number of Glossy phases between two prints of the accumulated statistics.
+ *        Default value: 10.
+ */
+#define STATS_PRINT_PHASES      10
+
+/**
+ * \brief If not zero, the outcome of each Glossy phase is sent as a binary
+ *        telemetry record (see glossy-telemetry.h) instead of lines of text.
+ *        Default value: 1.
+ */
+#define TELEMETRY               1
+
 /**
  * \brief Period during bootstrapping at receivers.
- *        It should not be an exact fraction of \link GLOSSY_PERIOD \endlink.
+ *        It should not be an exact fraction of \link GLOSSY_PERIOD_MIN \endlink.
  *        Default value: 69.474 ms.
  */
 #define GLOSSY_INIT_PERIOD      (GLOSSY_INIT_DURATION + RTIMER_SECOND / 100)                   //  69.474 ms
@@ -142,6 +187,30 @@
  */
 #define DATA_LEN                    sizeof(glossy_data_struct)
 
+/**
+ * \brief Maximum length of a batch of records, i.e., the largest data field
+ *        that fits in a 127-byte pipelined Glossy packet.
+ */
+#define BATCH_LEN_MAX               (127 - GLOSSY_HEADER_LEN - GLOSSY_SEQ_LEN - GLOSSY_RELAY_CNT_LEN - FOOTER_LEN)
+
+/**
+ * \brief Length of the batch header: record count and period level
+ *        announced for the next phase.
+ */
+#define BATCH_HDR_LEN               2
+
+/**
+ * \brief Maximum number of records in a batch.
+ *
+ * A batch is the batch header followed by the records, packed without padding.
+ */
+#define BATCH_RECORDS_MAX           ((BATCH_LEN_MAX - BATCH_HDR_LEN) / DATA_LEN)
+
+/**
+ * \brief Length of a batch carrying \p n records.
+ */
+#define BATCH_LEN(n)                (BATCH_HDR_LEN + (n) * DATA_LEN)
+
 /**
  * \brief Check if the nodeId matches the one of the initiator.
  */
@@ -164,23 +233,14 @@
 
 /**
  * \brief Get Glossy reference time.
- * \sa \link get_t_ref_l \endlink
+ * \sa \link get_t_ref_l_long \endlink
  */
-#define GLOSSY_REFERENCE_TIME       (get_t_ref_l())
-
-#define queue_length 256
+#define GLOSSY_REFERENCE_TIME       (get_t_ref_l_long())
 
-//const unsigned long queue_length = (int) 256;
-#define MAX_QUEUE_SIZE 60
-
-
-typedef struct{
-  glossy_data_struct glossy_data [MAX_QUEUE_SIZE];
-  int front;
-  int rear;
-  int count;
-
-} queueCDT;
+/**
+ * \brief Number of records in the traffic queue (a power of two, at most 128).
+ */
+#define QUEUE_SIZE                  64
 
 
 /** @} */
@@ -93,6 +93,9 @@
  */
 
 #include "glossy-test.h"
+#include "dev/glossy-stats.h"
+#include "dev/glossy-telemetry.h"
+#include "dev/uart1.h"
 
 /**
  * \defgroup glossy-test-variables Application variables
@@ -125,11 +128,10 @@ static int period_skew = 0;                /**< \brief Current estimation of clo
  * @{
  */
 
-static unsigned long packets_received = 0; /**< \brief Current number of received packets. */
-static unsigned long packets_missed = 0;   /**< \brief Current number of missed packets. */
+#if !TELEMETRY
 static unsigned long latency = 0;          /**< \brief Latency of last Glossy phase, in us. */
-static unsigned long sum_latency = 0;      /**< \brief Current sum of latencies, in ticks of low-frequency
-                                                clock (used to compute average). */
+#endif /* !TELEMETRY */
+static unsigned int phases_since_print = 0; /**< \brief Glossy phases since statistics were last printed. */
 
 /** @} */
 /** @} */
@@ -154,50 +156,43 @@ PROCESS_THREAD(glossy_print_stats_process, ev, data)
 		// Print statistics only if Glossy is not still bootstrapping.
 		if (!GLOSSY_IS_BOOTSTRAPPING()) {
 			if (get_rx_cnt()) {	// Packet received at least once.
-				// Increment number of successfully received packets.
-				packets_received++;
 				// Compute latency during last Glossy phase.
 				rtimer_clock_t lat = get_t_first_rx_l() - get_t_ref_l();
-				// Add last latency to sum of latencies.
-				sum_latency += lat;
+				// Add it to the statistics.
+				glossy_stats_update(1, lat);
+#if TELEMETRY
+				// Send the telemetry record of the last Glossy phase.
+				glossy_telemetry_send(glossy_data.seq_no, lat);
+#else /* TELEMETRY */
 				// Convert latency to microseconds.
-				latency = (unsigned long)(lat) * 1e6 / RTIMER_SECOND;
+				latency = GLOSSY_STATS_TICKS_TO_US(lat);
 				// Print information about last packet and related latency.
 				printf("Glossy received %u time%s: seq_no %lu, latency %lu.%03lu ms\n",
 						get_rx_cnt(), (get_rx_cnt() > 1) ? "s" : "", glossy_data.seq_no,
 								latency / 1000, latency % 1000);
+#endif /* TELEMETRY */
 			} else {	// Packet not received.
-				// Increment number of missed packets.
-				packets_missed++;
+				// Count the missed packet.
+				glossy_stats_update(0, 0);
+#if TELEMETRY
+				// Send the telemetry record of the last Glossy phase.
+				glossy_telemetry_send(GLOSSY_TELEMETRY_MISSED, 0);
+#else /* TELEMETRY */
 				// Print failed reception.
 				printf("Glossy NOT received\n");
+#endif /* TELEMETRY */
 			}
+			// Print the accumulated statistics every STATS_PRINT_PHASES phases.
+			if (++phases_since_print == STATS_PRINT_PHASES) {
+				phases_since_print = 0;
+				glossy_stats_print(GLOSSY_PERIOD);
 #if GLOSSY_DEBUG
-//			printf("skew %ld ppm\n", (long)(period_skew * 1e6) / GLOSSY_PERIOD);
-			printf("high_T_irq %u, rx_timeout %u, bad_length %u, bad_header %u, bad_crc %u\n",
-					high_T_irq, rx_timeout, bad_length, bad_header, bad_crc);
+				printf("high_T_irq %u, rx_timeout %u, bad_length %u, bad_header %u, bad_crc %u\n",
+						high_T_irq, rx_timeout, bad_length, bad_header, bad_crc);
 #endif /* GLOSSY_DEBUG */
-			// Compute current average reliability.
-			unsigned long avg_rel = packets_received * 1e5 / (packets_received + packets_missed);
-			// Print information about average reliability.
-			printf("average reliability %3lu.%03lu %% ",
-					avg_rel / 1000, avg_rel % 1000);
-			printf("(missed %lu out of %lu packets)\n",
-					packets_missed, packets_received + packets_missed);
-#if ENERGEST_CONF_ON
-			// Compute average radio-on time, in microseconds.
-			unsigned long avg_radio_on = (unsigned long)GLOSSY_PERIOD * 1e6 / RTIMER_SECOND *
-					(energest_type_time(ENERGEST_TYPE_LISTEN) + energest_type_time(ENERGEST_TYPE_TRANSMIT)) /
-					(energest_type_time(ENERGEST_TYPE_CPU) + energest_type_time(ENERGEST_TYPE_LPM));
-			// Print information about average radio-on time.
-			printf("average radio-on time %lu.%03lu ms\n",
-					avg_radio_on / 1000, avg_radio_on % 1000);
-#endif /* ENERGEST_CONF_ON */
-			// Compute average latency, in microseconds.
-			unsigned long avg_latency = sum_latency * 1e6 / (RTIMER_SECOND * packets_received);
-			// Print information about average latency.
-			printf("average latency %lu.%03lu ms\n",
-					avg_latency / 1000, avg_latency % 1000);
+				// Print the number of log bytes dropped because the UART was busy.
+				printf("uart1 dropped %lu bytes\n", uart1_tx_dropped());
+			}
 		}
 	}
 
@@ -247,6 +242,19 @@ static inline void estimate_period_skew(void) {
  * @{
  */
 
+char glossy_scheduler(struct rtimer *t, void *ptr);
+
+/**
+ * \brief Schedule the next Glossy phase at \p time, or whole periods later if
+ *        \p time has already passed (e.g., after a long Glossy phase).
+ */
+static void schedule_phase(struct rtimer *t, rtimer_clock_t time,
+		rtimer_clock_t period, void *ptr) {
+	while (rtimer_set(t, time, 1, (rtimer_callback_t)glossy_scheduler, ptr) == RTIMER_ERR_TIME) {
+		time += period;
+	}
+}
+
 char glossy_scheduler(struct rtimer *t, void *ptr) {
 	PT_BEGIN(&pt);
 
@@ -279,7 +287,7 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 				}
 			}
 			// Schedule begin of next Glossy phase based on GLOSSY_PERIOD.
-			rtimer_set(t, t_start + GLOSSY_PERIOD, 1, (rtimer_callback_t)glossy_scheduler, ptr);
+			schedule_phase(t, t_start + GLOSSY_PERIOD, GLOSSY_PERIOD, ptr);
 			// Estimate the clock skew over the last period.
 			estimate_period_skew();
 			// Poll the process that prints statistics (will be activated later by Contiki).
@@ -338,20 +346,18 @@ char glossy_scheduler(struct rtimer *t, void *ptr) {
 				if (skew_estimated == 0) {
 					// The reference time was not updated:
 					// Schedule begin of next Glossy phase based on last begin and GLOSSY_INIT_PERIOD.
-					rtimer_set(t, RTIMER_TIME(t) + GLOSSY_INIT_PERIOD, 1,
-							(rtimer_callback_t)glossy_scheduler, ptr);
+					schedule_phase(t, RTIMER_TIME(t) + GLOSSY_INIT_PERIOD, GLOSSY_INIT_PERIOD, ptr);
 				} else {
 					// The reference time was updated:
 					// Schedule begin of next Glossy phase based on reference time and GLOSSY_INIT_PERIOD.
-					rtimer_set(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD - GLOSSY_INIT_GUARD_TIME, 1,
-							(rtimer_callback_t)glossy_scheduler, ptr);
+					schedule_phase(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD - GLOSSY_INIT_GUARD_TIME,
+							GLOSSY_PERIOD, ptr);
 				}
 			} else {
 				// Glossy has already successfully bootstrapped:
 				// Schedule begin of next Glossy phase based on reference time and GLOSSY_PERIOD.
-				rtimer_set(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD +
-						period_skew - GLOSSY_GUARD_TIME * (1 + sync_missed), 1,
-						(rtimer_callback_t)glossy_scheduler, ptr);
+				schedule_phase(t, GLOSSY_REFERENCE_TIME + GLOSSY_PERIOD +
+						period_skew - GLOSSY_GUARD_TIME * (1 + sync_missed), GLOSSY_PERIOD, ptr);
 			}
 			// Poll the process that prints statistics (will be activated later by Contiki).
 			process_poll(&glossy_print_stats_process);
@@ -379,10 +385,17 @@ PROCESS_THREAD(glossy_test, ev, data)
 	leds_on(LEDS_RED);
 	// Initialize Glossy data.
 	glossy_data.seq_no = 0;
-	// Start print stats processes.
+	// Reset statistics and start print stats processes.
+	glossy_stats_init();
 	process_start(&glossy_print_stats_process, NULL);
 	// Start Glossy busy-waiting process.
 	process_start(&glossy_process, NULL);
+#if GLOSSY_CALIBRATE_IRQ
+	if (get_irq_delay() != GLOSSY_IRQ_DELAY) {
+		printf("**** Glossy IRQ delay %u, expected %u: update GLOSSY_CONF_IRQ_DELAY\n",
+				get_irq_delay(), GLOSSY_IRQ_DELAY);
+	}
+#endif /* GLOSSY_CALIBRATE_IRQ */
 
 	// Start Glossy experiment in one second.
 	rtimer_set(&rt, RTIMER_NOW() + RTIMER_SECOND, 1, (rtimer_callback_t)glossy_scheduler, NULL);
@@ -102,6 +102,19 @@
  */
 #define GLOSSY_BOOTSTRAP_PERIODS 3
 
+/**
+ * \brief Number of Glossy phases between two prints of the accumulated statistics.
+ *        Default value: 10.
+ */
+#define STATS_PRINT_PHASES      10
+
+/**
+ * \brief If not zero, the outcome of each Glossy phase is sent as a binary
+ *        telemetry record (see glossy-telemetry.h) instead of lines of text.
+ *        Default value: 1.
+ */
+#define TELEMETRY               1
+
 /**
  * \brief Period during bootstrapping at receivers.
  *        It should not be an exact fraction of \link GLOSSY_PERIOD \endlink.
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy hardware abstraction layer for the CC2420 radio
+ *         connected to the MSP430 USART0 (SPI) and Timer B (SFD capture).
+ */
+
+#ifndef GLOSSY_HAL_CC2420_H_
+#define GLOSSY_HAL_CC2420_H_
+
+#include "contiki.h"
+#include "dev/cc2420_const.h"
+#include "dev/spi.h"
+#include <legacymsp430.h>
+
+#define GLOSSY_HAL_XOSC_STABLE          BV(CC2420_XOSC16M_STABLE)
+
+/* ----------------------------- Radio ------------------------------ */
+static inline uint8_t glossy_hal_radio_status(void) {
+	uint8_t status;
+	FASTSPI_UPD_STATUS(status);
+	return status;
+}
+
+static inline void glossy_hal_radio_rx_on(void) {
+	FASTSPI_STROBE(CC2420_SRXON);
+}
+
+static inline void glossy_hal_radio_off(void) {
+	FASTSPI_STROBE(CC2420_SRFOFF);
+}
+
+static inline void glossy_hal_radio_start_tx(void) {
+	FASTSPI_STROBE(CC2420_STXON);
+}
+
+static inline void glossy_hal_radio_write_tx(const uint8_t *buf, uint8_t len) {
+	FASTSPI_WRITE_FIFO(buf, len);
+}
+
+#ifdef SPI_DMA_WRITE
+static inline void glossy_hal_radio_write_tx_start(const uint8_t *buf, uint8_t len) {
+	FASTSPI_WRITE_FIFO_DMA(buf, len);
+}
+
+static inline void glossy_hal_radio_write_tx_end(void) {
+	FASTSPI_DMA_END();
+}
+#else /* SPI_DMA_WRITE */
+static inline void glossy_hal_radio_write_tx_start(const uint8_t *buf, uint8_t len) {
+	FASTSPI_WRITE_FIFO(buf, len);
+}
+
+static inline void glossy_hal_radio_write_tx_end(void) {
+}
+#endif /* SPI_DMA_WRITE */
+
+static inline void glossy_hal_radio_flush_tx(void) {
+	FASTSPI_STROBE(CC2420_SFLUSHTX);
+}
+
+static inline uint8_t glossy_hal_radio_read_byte(void) {
+	uint8_t b;
+	FASTSPI_READ_FIFO_BYTE(b);
+	return b;
+}
+
+static inline void glossy_hal_radio_flush_rx(void) {
+	glossy_hal_radio_read_byte();
+	FASTSPI_STROBE(CC2420_SFLUSHRX);
+	FASTSPI_STROBE(CC2420_SFLUSHRX);
+}
+
+static inline void glossy_hal_radio_read(uint8_t *buf, uint8_t len) {
+	FASTSPI_READ_FIFO_NO_WAIT(buf, len);
+}
+
+static inline uint8_t glossy_hal_sfd_is_1(void) {
+	return SFD_IS_1;
+}
+
+static inline uint8_t glossy_hal_fifo_is_1(void) {
+	return FIFO_IS_1;
+}
+
+static inline uint8_t glossy_hal_fifop_is_1(void) {
+	return FIFOP_IS_1;
+}
+
+static inline void glossy_hal_radio_set_fifop_threshold(uint8_t thr) {
+	FASTSPI_SETREG(CC2420_IOCFG0, thr & 0x7f);
+}
+
+/* ---------------------------- FIFOP pin --------------------------- */
+#define GLOSSY_HAL_FIFOP_VECTOR         PORT1_VECTOR
+
+/* ---------------------------- SFD timer --------------------------- */
+#define GLOSSY_HAL_SFD_VECTOR           TIMERB1_VECTOR
+#define GLOSSY_HAL_IV_INITIATOR_TIMEOUT TBIV_TBCCR4
+#define GLOSSY_HAL_IV_RX_TIMEOUT        TBIV_TBCCR5
+
+static inline rtimer_clock_t glossy_hal_sfd_time(void) {
+	return TBCCR1;
+}
+
+static inline rtimer_clock_t glossy_hal_now_dco(void) {
+	return RTIMER_NOW_DCO();
+}
+
+static inline uint16_t glossy_hal_timer_iv(void) {
+	return TBIV;
+}
+
+static inline void glossy_hal_initiator_timeout_set(rtimer_clock_t t) {
+	TBCCR4 = t;
+	TBCCTL4 = CCIE;
+}
+
+static inline void glossy_hal_initiator_timeout_stop(void) {
+	TBCCTL4 = 0;
+}
+
+static inline void glossy_hal_rx_timeout_set(rtimer_clock_t t) {
+	TBCCR5 = t;
+	TBCCTL5 = CCIE;
+}
+
+static inline void glossy_hal_rx_timeout_stop(void) {
+	TBCCTL5 = 0;
+}
+
+/**
+ * \defgroup glossy_capture Timer capture of clock ticks
+ * @{
+ */
+
+/* -------------------------- Clock Capture ------------------------- */
+/**
+ * \brief Capture next low-frequency clock tick and DCO clock value at that instant.
+ * \param t_cap_h variable for storing value of DCO clock value
+ * \param t_cap_l variable for storing value of low-frequency clock value
+ */
+#define CAPTURE_NEXT_CLOCK_TICK(t_cap_h, t_cap_l) do {\
+		/* Enable capture mode for timers B6 and A2 (ACLK) */\
+		TBCCTL6 = CCIS0 | CM_POS | CAP | SCS; \
+		TACCTL2 = CCIS0 | CM_POS | CAP | SCS; \
+		/* Wait until both timers capture the next clock tick */\
+		while (!((TBCCTL6 & CCIFG) && (TACCTL2 & CCIFG))); \
+		/* Store the capture timer values */\
+		t_cap_h = TBCCR6; \
+		t_cap_l = TACCR2; \
+		/* Disable capture mode */\
+		TBCCTL6 = 0; \
+		TACCTL2 = 0; \
+} while (0)
+
+/** @} */
+
+/* -------------------------------- SFD ----------------------------- */
+
+/**
+ * \defgroup glossy_sfd Management of SFD interrupts
+ * @{
+ */
+
+/**
+ * \brief Capture instants of SFD events on timer B1
+ * \param edge Edge used for capture.
+ *
+ */
+#define SFD_CAP_INIT(edge) do {\
+	P4SEL |= BV(SFD);\
+	TBCCTL1 = edge | CAP | SCS;\
+} while (0)
+
+/**
+ * \brief Enable generation of interrupts due to SFD events
+ */
+#define ENABLE_SFD_INT()		do { TBCCTL1 |= CCIE; } while (0)
+
+/**
+ * \brief Disable generation of interrupts due to SFD events
+ */
+#define DISABLE_SFD_INT()		do { TBCCTL1 &= ~CCIE; } while (0)
+
+/**
+ * \brief Clear interrupt flag due to SFD events
+ */
+#define CLEAR_SFD_INT()			do { TBCCTL1 &= ~CCIFG; } while (0)
+
+/**
+ * \brief Check if generation of interrupts due to SFD events is enabled
+ */
+#define IS_ENABLED_SFD_INT()    !!(TBCCTL1 & CCIE)
+
+/**
+ * \brief Source Timer B from the DCO, as during a Glossy phase, for captures
+ *        triggered by software; saves the configuration of Timer B and of the
+ *        SFD capture register in \p tbctl and \p tbcctl1.
+ */
+#define SFD_CAP_SW_TIMER_INIT(tbctl, tbcctl1) do {\
+	tbctl = TBCTL;\
+	tbcctl1 = TBCCTL1;\
+	TBCTL = 0;\
+	TBCTL = TBSSEL1;\
+	TBCTL |= MC1;\
+} while (0)
+
+/**
+ * \brief Restore the configuration saved by SFD_CAP_SW_TIMER_INIT.
+ */
+#define SFD_CAP_SW_TIMER_RESTORE(tbctl, tbcctl1) do {\
+	TBCCTL1 = tbcctl1;\
+	TBCTL = 0;\
+	TBCTL = tbctl;\
+} while (0)
+
+/**
+ * \brief Prepare a capture triggered by software on the SFD capture register,
+ *        with interrupt: the capture input is connected to GND.
+ */
+#define SFD_CAP_SW_INIT() do {\
+	TBCCTL1 = CM_1 | CCIS1 | CAP | SCS | CCIE;\
+} while (0)
+
+/**
+ * \brief Trigger the capture: the capture input goes from GND to VCC
+ */
+#define SFD_CAP_SW_TRIGGER()	do { TBCCTL1 |= CCIS0; } while (0)
+
+/**
+ * \brief Check if a capture is pending, i.e., its interrupt has not been served yet
+ */
+#define IS_PENDING_SFD_INT()	!!(TBCCTL1 & CCIFG)
+
+/** @} */
+
+#endif /* GLOSSY_HAL_CC2420_H_ */
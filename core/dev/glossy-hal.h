@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy hardware abstraction layer, header file.
+ *
+ *         Glossy accesses the radio and the timer that captures SFD
+ *         events only through the functions and macros listed below,
+ *         prefixed with glossy_hal_ / GLOSSY_HAL_. A backend implements
+ *         all of them as static inline functions (or macros) in a header
+ *         file, so that the calls are resolved at compile time and cost
+ *         nothing with respect to direct register accesses.
+ *
+ *         The backend is selected with GLOSSY_CONF_HAL in contiki-conf.h
+ *         or project-conf.h, e.g.
+ *         \code #define GLOSSY_CONF_HAL "dev/glossy-hal-cc2420.h" \endcode
+ *         By default, the CC2420 backend for the MSP430 Timer B is used.
+ *
+ *         Radio:
+ *         - uint8_t glossy_hal_radio_status(void): status byte, with
+ *           GLOSSY_HAL_XOSC_STABLE set once the oscillator is stable.
+ *         - void glossy_hal_radio_rx_on(void): enter (or go back to) RX.
+ *         - void glossy_hal_radio_off(void): turn off the radio.
+ *         - void glossy_hal_radio_start_tx(void): transmit the content of
+ *           the TX buffer; it may be written during TX calibration.
+ *         - void glossy_hal_radio_write_tx(const uint8_t *buf, uint8_t len):
+ *           write the length field and the payload to the TX buffer.
+ *         - void glossy_hal_radio_write_tx_start(const uint8_t *buf, uint8_t len),
+ *           glossy_hal_radio_write_tx_end(void): same, but the write may
+ *           go on in the background (e.g., by DMA) after the first call
+ *           returns; buf must not change and the radio must not be
+ *           accessed until the second call, which does nothing if no
+ *           write is pending.
+ *         - void glossy_hal_radio_flush_tx(void), glossy_hal_radio_flush_rx(void)
+ *         - uint8_t glossy_hal_radio_read_byte(void): read one byte of the
+ *           packet being received.
+ *         - void glossy_hal_radio_read(uint8_t *buf, uint8_t len): read the
+ *           remaining bytes, including RSSI and CRC/correlation.
+ *         - uint8_t glossy_hal_sfd_is_1(void), glossy_hal_fifo_is_1(void):
+ *           state of the SFD pin and of the RX FIFO (not empty).
+ *         - uint8_t glossy_hal_fifop_is_1(void): state of the FIFOP pin,
+ *           set while more bytes than the threshold are in the RX FIFO.
+ *         - void glossy_hal_radio_set_fifop_threshold(uint8_t thr)
+ *
+ *         FIFOP interrupt (only with GLOSSY_CONF_RX_CHUNK):
+ *         - GLOSSY_HAL_FIFOP_VECTOR: interrupt vector of FIFOP rising edges,
+ *           enabled and cleared with ENABLE_FIFOP_INT(), DISABLE_FIFOP_INT(),
+ *           CLEAR_FIFOP_INT() and FIFOP_INT_INIT() of the platform.
+ *
+ *         SFD timer (clocked by the DCO while Glossy runs):
+ *         - GLOSSY_HAL_SFD_VECTOR: interrupt vector of SFD edges and timeouts.
+ *         - rtimer_clock_t glossy_hal_sfd_time(void): time of the last SFD edge.
+ *         - rtimer_clock_t glossy_hal_now_dco(void): current time.
+ *         - uint16_t glossy_hal_timer_iv(void): source of the interrupt,
+ *           GLOSSY_HAL_IV_INITIATOR_TIMEOUT, GLOSSY_HAL_IV_RX_TIMEOUT, or
+ *           any other value for SFD edges; reading it clears the flag.
+ *         - void glossy_hal_initiator_timeout_set(rtimer_clock_t t),
+ *           glossy_hal_initiator_timeout_stop(void),
+ *           glossy_hal_rx_timeout_set(rtimer_clock_t t),
+ *           glossy_hal_rx_timeout_stop(void)
+ *         - SFD_CAP_INIT(edge), ENABLE_SFD_INT(), DISABLE_SFD_INT(),
+ *           CLEAR_SFD_INT(), IS_ENABLED_SFD_INT()
+ *         - SFD_CAP_SW_TIMER_INIT(tbctl, tbcctl1),
+ *           SFD_CAP_SW_TIMER_RESTORE(tbctl, tbcctl1), SFD_CAP_SW_INIT(),
+ *           SFD_CAP_SW_TRIGGER(), IS_PENDING_SFD_INT(): capture on the SFD
+ *           register triggered by software, which raises the same interrupt
+ *           as an SFD edge, with the timer clocked as during a Glossy phase
+ *           (only with GLOSSY_CONF_CALIBRATE_IRQ)
+ *         - CAPTURE_NEXT_CLOCK_TICK(t_cap_h, t_cap_l)
+ */
+
+#ifndef GLOSSY_HAL_H_
+#define GLOSSY_HAL_H_
+
+#include "contiki.h"
+
+#ifdef GLOSSY_CONF_HAL
+#include GLOSSY_CONF_HAL
+#else /* GLOSSY_CONF_HAL */
+#include "dev/glossy-hal-cc2420.h"
+#endif /* GLOSSY_CONF_HAL */
+
+#endif /* GLOSSY_HAL_H_ */
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy statistics, integer-only accumulators.
+ */
+
+#include "dev/glossy-stats.h"
+#include <stdio.h>
+
+static unsigned long received, missed;
+static unsigned long sum_latency;     /**< Sum of latencies, in low-frequency clock ticks */
+static rtimer_clock_t min_latency, max_latency;
+static unsigned short hist[GLOSSY_STATS_HIST_BINS];
+
+/*---------------------------------------------------------------------------*/
+/*
+ * a * b / c with 32-bit intermediates: if a * b does not fit, a and c
+ * are scaled down together, losing only low-order bits of the result.
+ */
+static unsigned long
+muldiv(unsigned long a, unsigned long b, unsigned long c)
+{
+  while(b != 0 && a > 0xffffffffUL / b && c > 1) {
+    a >>= 1;
+    c >>= 1;
+  }
+  return c ? a * b / c : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_stats_init(void)
+{
+  uint8_t i;
+
+  received = missed = 0;
+  sum_latency = 0;
+  min_latency = (rtimer_clock_t)-1;
+  max_latency = 0;
+  for(i = 0; i < GLOSSY_STATS_HIST_BINS; i++) {
+    hist[i] = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_stats_update(uint8_t rx, rtimer_clock_t latency)
+{
+  rtimer_clock_t bin;
+
+  if(!rx) {
+    missed++;
+    return;
+  }
+  received++;
+  sum_latency += latency;
+  if(latency < min_latency) {
+    min_latency = latency;
+  }
+  if(latency > max_latency) {
+    max_latency = latency;
+  }
+  bin = latency / GLOSSY_STATS_HIST_WIDTH;
+  if(bin >= GLOSSY_STATS_HIST_BINS) {
+    bin = GLOSSY_STATS_HIST_BINS - 1;
+  }
+  if(hist[bin] < 0xffff) {
+    hist[bin]++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_stats_get(struct glossy_stats *s, unsigned long period)
+{
+  uint8_t i;
+
+  s->received = received;
+  s->missed = missed;
+  s->reliability = muldiv(received, 100000UL, received + missed);
+  s->latency_avg = muldiv(sum_latency, 1000000UL / 64,
+                          (RTIMER_SECOND / 64) * received);
+  s->latency_min = received ? GLOSSY_STATS_TICKS_TO_US(min_latency) : 0;
+  s->latency_max = GLOSSY_STATS_TICKS_TO_US(max_latency);
+#if ENERGEST_CONF_ON
+  s->radio_on = muldiv(energest_type_time(ENERGEST_TYPE_LISTEN) +
+                       energest_type_time(ENERGEST_TYPE_TRANSMIT),
+                       muldiv(period, 1000000UL / 64, RTIMER_SECOND / 64),
+                       energest_type_time(ENERGEST_TYPE_CPU) +
+                       energest_type_time(ENERGEST_TYPE_LPM));
+#else /* ENERGEST_CONF_ON */
+  s->radio_on = 0;
+#endif /* ENERGEST_CONF_ON */
+  for(i = 0; i < GLOSSY_STATS_HIST_BINS; i++) {
+    s->hist[i] = hist[i];
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_stats_print(unsigned long period)
+{
+  struct glossy_stats s;
+  uint8_t i;
+
+  glossy_stats_get(&s, period);
+  printf("average reliability %3lu.%03lu %% ",
+         s.reliability / 1000, s.reliability % 1000);
+  printf("(missed %lu out of %lu packets)\n",
+         s.missed, s.received + s.missed);
+#if ENERGEST_CONF_ON
+  printf("average radio-on time %lu.%03lu ms per %lu ms\n",
+         s.radio_on / 1000, s.radio_on % 1000,
+         muldiv(period, 1000, RTIMER_SECOND));
+#endif /* ENERGEST_CONF_ON */
+  printf("average latency %lu.%03lu ms (min %lu.%03lu, max %lu.%03lu)\n",
+         s.latency_avg / 1000, s.latency_avg % 1000,
+         s.latency_min / 1000, s.latency_min % 1000,
+         s.latency_max / 1000, s.latency_max % 1000);
+  printf("latency histogram (%lu us bins):",
+         GLOSSY_STATS_TICKS_TO_US(GLOSSY_STATS_HIST_WIDTH));
+  for(i = 0; i < GLOSSY_STATS_HIST_BINS; i++) {
+    printf(" %u", s.hist[i]);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy statistics, header file.
+ *
+ *         Integer-only accumulators for the outcome of Glossy phases:
+ *         reliability, mean/min/max latency and a latency histogram,
+ *         plus the radio-on time measured by energest. Applications
+ *         record each phase with glossy_stats_update() and print or
+ *         export the accumulated results only when needed, with
+ *         glossy_stats_print() or glossy_stats_get().
+ *
+ *         The histogram has GLOSSY_STATS_CONF_HIST_BINS bins of
+ *         GLOSSY_STATS_CONF_HIST_WIDTH low-frequency clock ticks each;
+ *         the last bin also counts all larger latencies.
+ */
+
+#ifndef GLOSSY_STATS_H_
+#define GLOSSY_STATS_H_
+
+#include "contiki.h"
+
+#ifdef GLOSSY_STATS_CONF_HIST_BINS
+#define GLOSSY_STATS_HIST_BINS        GLOSSY_STATS_CONF_HIST_BINS
+#else /* GLOSSY_STATS_CONF_HIST_BINS */
+#define GLOSSY_STATS_HIST_BINS        8
+#endif /* GLOSSY_STATS_CONF_HIST_BINS */
+
+#ifdef GLOSSY_STATS_CONF_HIST_WIDTH
+#define GLOSSY_STATS_HIST_WIDTH       GLOSSY_STATS_CONF_HIST_WIDTH
+#else /* GLOSSY_STATS_CONF_HIST_WIDTH */
+#define GLOSSY_STATS_HIST_WIDTH       (RTIMER_SECOND / 512)     // 1.953 ms
+#endif /* GLOSSY_STATS_CONF_HIST_WIDTH */
+
+/**
+ * Convert a duration in low-frequency clock ticks (at most 0xffff) to
+ * microseconds with integer arithmetic only (exact if RTIMER_SECOND is a
+ * multiple of 64).
+ */
+#define GLOSSY_STATS_TICKS_TO_US(t) \
+  ((unsigned long)(t) * (1000000uL / 64) / (RTIMER_SECOND / 64))
+
+/**
+ * Accumulated statistics, as returned by glossy_stats_get().
+ */
+struct glossy_stats {
+  unsigned long received;        /**< Phases in which the packet was received */
+  unsigned long missed;          /**< Phases in which it was not */
+  unsigned long reliability;     /**< received / (received + missed), in units of 0.001 % */
+  unsigned long latency_avg;     /**< Mean latency, in us */
+  unsigned long latency_min;     /**< Minimum latency, in us */
+  unsigned long latency_max;     /**< Maximum latency, in us */
+  unsigned long radio_on;        /**< Radio-on time per period, in us */
+  unsigned short hist[GLOSSY_STATS_HIST_BINS]; /**< Latency histogram */
+};
+
+/**
+ * \brief Reset all accumulators.
+ */
+void glossy_stats_init(void);
+
+/**
+ * \brief Record the outcome of a Glossy phase.
+ * \param received Not zero if the packet was received.
+ * \param latency  Latency of the phase, in low-frequency clock ticks
+ *                 (ignored if the packet was not received).
+ */
+void glossy_stats_update(uint8_t received, rtimer_clock_t latency);
+
+/**
+ * \brief Compute the accumulated statistics.
+ * \param s        Where to store them.
+ * \param period   Period over which the radio-on time is reported,
+ *                 in low-frequency clock ticks.
+ */
+void glossy_stats_get(struct glossy_stats *s, unsigned long period);
+
+/**
+ * \brief Print the accumulated statistics.
+ * \param period   Period over which the radio-on time is reported,
+ *                 in low-frequency clock ticks.
+ */
+void glossy_stats_print(unsigned long period);
+
+#endif /* GLOSSY_STATS_H_ */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy telemetry, binary records over UART1.
+ */
+
+#include "dev/glossy-telemetry.h"
+#include "dev/glossy.h"
+#include "dev/uart1.h"
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+#if ENERGEST_CONF_ON
+static unsigned long energest_last[4];
+static const uint8_t energest_types[4] = {
+  ENERGEST_TYPE_CPU, ENERGEST_TYPE_LPM,
+  ENERGEST_TYPE_LISTEN, ENERGEST_TYPE_TRANSMIT
+};
+#endif /* ENERGEST_CONF_ON */
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+crc_byte(uint16_t crc, uint8_t b)
+{
+  crc = (uint8_t)(crc >> 8) | (crc << 8);
+  crc ^= b;
+  crc ^= (uint8_t)(crc & 0xff) >> 4;
+  crc ^= crc << 12;
+  crc ^= (crc & 0xff) << 5;
+  return crc;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put16(uint8_t *p, uint16_t v)
+{
+  *p++ = v & 0xff;
+  *p++ = v >> 8;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put32(uint8_t *p, uint32_t v)
+{
+  p = put16(p, v & 0xffff);
+  return put16(p, v >> 16);
+}
+/*---------------------------------------------------------------------------*/
+/* Append the CRC to a record of len bytes and send it as a SLIP frame. */
+static void
+send_record(uint8_t *buf, uint8_t len)
+{
+  uint16_t crc = 0;
+  uint8_t i;
+
+  for(i = 0; i < len; i++) {
+    crc = crc_byte(crc, buf[i]);
+  }
+  put16(&buf[len], crc);
+  len += 2;
+
+  uart1_writeb(SLIP_END);
+  for(i = 0; i < len; i++) {
+    if(buf[i] == SLIP_END) {
+      uart1_writeb(SLIP_ESC);
+      uart1_writeb(SLIP_ESC_END);
+    } else if(buf[i] == SLIP_ESC) {
+      uart1_writeb(SLIP_ESC);
+      uart1_writeb(SLIP_ESC_ESC);
+    } else {
+      uart1_writeb(buf[i]);
+    }
+  }
+  uart1_writeb(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
+void
+glossy_telemetry_send(unsigned long seq_no, rtimer_clock_t latency)
+{
+  uint8_t buf[GLOSSY_TELEMETRY_LEN], *p = buf;
+  uint8_t i;
+
+  *p++ = GLOSSY_TELEMETRY_TYPE;
+  p = put32(p, seq_no);
+  *p++ = get_rx_cnt();
+  *p++ = get_relay_cnt();
+  p = put16(p, get_T_slot_h());
+  p = put16(p, latency);
+  for(i = 0; i < 4; i++) {
+#if ENERGEST_CONF_ON
+    unsigned long now = energest_type_time(energest_types[i]);
+    if(now < energest_last[i]) {
+      /* energest was reset */
+      energest_last[i] = 0;
+    }
+    p = put32(p, now - energest_last[i]);
+    energest_last[i] = now;
+#else /* ENERGEST_CONF_ON */
+    p = put32(p, 0);
+#endif /* ENERGEST_CONF_ON */
+  }
+  send_record(buf, p - buf);
+}
+/*---------------------------------------------------------------------------*/
+#if PROCESS_PROFILE
+void
+glossy_telemetry_send_profile(void)
+{
+  uint8_t buf[GLOSSY_TELEMETRY_PROFILE_LEN_MAX], *p;
+  struct process *q;
+  const char *name;
+
+  for(q = PROCESS_LIST(); q != NULL; q = q->next) {
+    p = buf;
+    *p++ = GLOSSY_TELEMETRY_PROFILE_TYPE;
+    p = put16(p, q->prof_calls);
+    p = put32(p, q->prof_ticks);
+    p = put16(p, q->prof_max);
+    for(name = q->name; *name != '\0' &&
+          p < &buf[GLOSSY_TELEMETRY_PROFILE_LEN_MAX - 2]; name++) {
+      *p++ = *name;
+    }
+    send_record(buf, p - buf);
+  }
+}
+#endif /* PROCESS_PROFILE */
+/*---------------------------------------------------------------------------*/
+#if MSP430_STACK_PAINT
+void
+glossy_telemetry_send_memory(void)
+{
+  uint8_t buf[GLOSSY_TELEMETRY_MEMORY_LEN], *p = buf;
+
+  *p++ = GLOSSY_TELEMETRY_MEMORY_TYPE;
+  p = put16(p, msp430_stack_max());
+  p = put16(p, msp430_stack_margin());
+  p = put16(p, msp430_heap_used());
+  send_record(buf, p - buf);
+}
+#endif /* MSP430_STACK_PAINT */
+/*---------------------------------------------------------------------------*/
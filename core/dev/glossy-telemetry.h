@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Glossy telemetry, header file.
+ *
+ *         Compact binary record of the outcome of a Glossy phase, sent
+ *         over UART1 instead of several lines of text. Each record is a
+ *         SLIP frame (END, escaped payload, END), so that it can be
+ *         interleaved with text output; the payload is little-endian:
+ *
+ *         offset  size  field
+ *              0     1  type (GLOSSY_TELEMETRY_TYPE)
+ *              1     4  seq_no (GLOSSY_TELEMETRY_MISSED if no packet
+ *                       was received in the phase, or if the packets
+ *                       carried no record; rx_cnt tells them apart)
+ *              5     1  rx_cnt
+ *              6     1  relay_cnt
+ *              7     2  T_slot_h, in DCO ticks
+ *              9     2  latency, in low-frequency clock ticks
+ *             11     4  energest CPU time since the previous record
+ *             15     4  energest LPM time since the previous record
+ *             19     4  energest listen time since the previous record
+ *             23     4  energest transmit time since the previous record
+ *             27     2  CRC-16 (as in TinyOS serial frames) of bytes 0..26
+ *
+ *         Energest times are in low-frequency clock ticks.
+ *
+ *         With PROCESS_CONF_PROFILE, the profile of each process can be
+ *         sent as well, in records of variable length:
+ *
+ *         offset  size  field
+ *              0     1  type (GLOSSY_TELEMETRY_PROFILE_TYPE)
+ *              1     2  number of calls
+ *              3     4  total time, in low-frequency clock ticks
+ *              7     2  longest call, in low-frequency clock ticks
+ *              9     n  process name, not terminated (n <= 16)
+ *            9+n     2  CRC-16 of bytes 0..8+n
+ *
+ *         With MSP430_CONF_STACK_PAINT, the use of RAM can be sent as
+ *         well:
+ *
+ *         offset  size  field
+ *              0     1  type (GLOSSY_TELEMETRY_MEMORY_TYPE)
+ *              1     2  stack high-watermark, in bytes
+ *              3     2  free RAM between the heap and the high-watermark
+ *              5     2  heap size, in bytes
+ *              7     2  CRC-16 of bytes 0..6
+ *
+ *         tools/sky/telemetrydump.c decodes the records on the host.
+ */
+
+#ifndef GLOSSY_TELEMETRY_H_
+#define GLOSSY_TELEMETRY_H_
+
+#include "contiki.h"
+
+/**
+ * Type byte of telemetry records.
+ */
+#define GLOSSY_TELEMETRY_TYPE         0x47
+
+/**
+ * Length of a telemetry record, CRC included, before SLIP escaping.
+ */
+#define GLOSSY_TELEMETRY_LEN          29
+
+/**
+ * Sequence number sent for a phase in which no packet was received.
+ */
+#define GLOSSY_TELEMETRY_MISSED       0xffffffffUL
+
+/**
+ * Type byte of process profile records.
+ */
+#define GLOSSY_TELEMETRY_PROFILE_TYPE 0x50
+
+/**
+ * Maximum length of a process profile record, CRC included.
+ */
+#define GLOSSY_TELEMETRY_PROFILE_LEN_MAX (9 + 16 + 2)
+
+/**
+ * Type byte of memory records.
+ */
+#define GLOSSY_TELEMETRY_MEMORY_TYPE  0x4d
+
+/**
+ * Length of a memory record, CRC included.
+ */
+#define GLOSSY_TELEMETRY_MEMORY_LEN   9
+
+/**
+ * \brief Send the telemetry record of the last Glossy phase.
+ * \param seq_no   Application sequence number of the phase, or
+ *                 GLOSSY_TELEMETRY_MISSED if the packet was not received
+ *                 or carried no record.
+ * \param latency  Latency of the phase, in low-frequency clock ticks
+ *                 (0 if the packet was not received).
+ *
+ * The other fields are read from Glossy and energest.
+ */
+void glossy_telemetry_send(unsigned long seq_no, rtimer_clock_t latency);
+
+#if PROCESS_PROFILE
+/**
+ * \brief Send one profile record for each running process
+ *        (see PROCESS_CONF_PROFILE).
+ */
+void glossy_telemetry_send_profile(void);
+#endif /* PROCESS_PROFILE */
+
+#if MSP430_STACK_PAINT
+/**
+ * \brief Send a memory record (see MSP430_CONF_STACK_PAINT).
+ *
+ * Scans the free RAM for the stack high-watermark.
+ */
+void glossy_telemetry_send_memory(void);
+#endif /* MSP430_STACK_PAINT */
+
+#endif /* GLOSSY_TELEMETRY_H_ */
@@ -39,6 +39,8 @@
 
 #include "glossy.h"
 
+#include <string.h>
+
 #define CM_POS              CM_1
 #define CM_NEG              CM_2
 #define CM_BOTH             CM_3
@@ -48,17 +50,24 @@ static glossy_data_struct *data;
 static uint8_t *packet;
 static uint8_t data_len, packet_len, packet_len_tmp, header;
 static uint8_t bytes_read, tx_relay_cnt_last, n_timeouts;
+static uint8_t n_pkts, seq, seq_len, seq_last, seq_mask, pkt_rx_cnt, inject, relay_cnt_base;
 static volatile uint8_t state;
 static rtimer_clock_t t_rx_start, t_rx_stop, t_tx_start, t_tx_stop, t_start;
 static rtimer_clock_t t_rx_timeout;
-static rtimer_clock_t T_irq;
+static rtimer_clock_t T_irq, irq_delay = GLOSSY_IRQ_DELAY, irq_delay_measured = GLOSSY_IRQ_DELAY;
 static rtimer_clock_t t_stop;
 static rtimer_callback_t cb;
 static struct rtimer *rtimer;
 static void *ptr;
+#if GLOSSY_LPM
+static struct rtimer stop_rtimer;
+static uint8_t stop_rtimer_set;
+#endif /* GLOSSY_LPM */
 static unsigned short ie1, ie2, p1ie, p2ie, tbiv;
+static unsigned short dma0ie, dma1ie, dma2ie, me2, taie;
 
 static rtimer_clock_t T_slot_h, T_rx_h, T_w_rt_h, T_tx_h, T_w_tr_h, t_ref_l, T_offset_h, t_first_rx_l;
+static rtimer_long_clock_t t_ref_l_long;
 #if GLOSSY_SYNC_WINDOW
 static unsigned long T_slot_h_sum;
 static uint8_t win_cnt;
@@ -66,19 +75,22 @@ static uint8_t win_cnt;
 static uint8_t relay_cnt, t_ref_l_updated;
 
 /* --------------------------- Radio functions ---------------------- */
-static inline void radio_flush_tx(void) {
-	FASTSPI_STROBE(CC2420_SFLUSHTX);
+static inline void radio_write_tx_end(void) {
+#if GLOSSY_TX_DMA
+	// complete a background write to the TXFIFO, if any
+	glossy_hal_radio_write_tx_end();
+#endif /* GLOSSY_TX_DMA */
 }
 
-static inline uint8_t radio_status(void) {
-	uint8_t status;
-	FASTSPI_UPD_STATUS(status);
-	return status;
+static inline void radio_flush_tx(void) {
+	radio_write_tx_end();
+	glossy_hal_radio_flush_tx();
 }
 
 static inline void radio_on(void) {
-	FASTSPI_STROBE(CC2420_SRXON);
-	while(!(radio_status() & (BV(CC2420_XOSC16M_STABLE))));
+	radio_write_tx_end();
+	glossy_hal_radio_rx_on();
+	while(!(glossy_hal_radio_status() & GLOSSY_HAL_XOSC_STABLE));
 	ENERGEST_ON(ENERGEST_TYPE_LISTEN);
 }
 
@@ -91,14 +103,13 @@ static inline void radio_off(void) {
 		ENERGEST_OFF(ENERGEST_TYPE_LISTEN);
 	}
 #endif /* ENERGEST_CONF_ON */
-	FASTSPI_STROBE(CC2420_SRFOFF);
+	radio_write_tx_end();
+	glossy_hal_radio_off();
 }
 
 static inline void radio_flush_rx(void) {
-	uint8_t dummy;
-	FASTSPI_READ_FIFO_BYTE(dummy);
-	FASTSPI_STROBE(CC2420_SFLUSHRX);
-	FASTSPI_STROBE(CC2420_SFLUSHRX);
+	radio_write_tx_end();
+	glossy_hal_radio_flush_rx();
 }
 
 static inline void radio_abort_rx(void) {
@@ -107,7 +118,8 @@ static inline void radio_abort_rx(void) {
 }
 
 static inline void radio_abort_tx(void) {
-	FASTSPI_STROBE(CC2420_SRXON);
+	radio_write_tx_end();
+	glossy_hal_radio_rx_on();
 #if ENERGEST_CONF_ON
 	if (energest_current_mode[ENERGEST_TYPE_TRANSMIT]) {
 		ENERGEST_OFF(ENERGEST_TYPE_TRANSMIT);
@@ -118,7 +130,7 @@ static inline void radio_abort_tx(void) {
 }
 
 static inline void radio_start_tx(void) {
-	FASTSPI_STROBE(CC2420_STXON);
+	glossy_hal_radio_start_tx();
 #if ENERGEST_CONF_ON
 	ENERGEST_OFF(ENERGEST_TYPE_LISTEN);
 	ENERGEST_ON(ENERGEST_TYPE_TRANSMIT);
@@ -126,26 +138,215 @@ static inline void radio_start_tx(void) {
 }
 
 static inline void radio_write_tx(void) {
-	FASTSPI_WRITE_FIFO(packet, packet_len_tmp - 1);
+	radio_write_tx_end();
+	glossy_hal_radio_write_tx(packet, packet_len_tmp - 1);
+}
+
+static inline void radio_write_tx_start(void) {
+#if GLOSSY_TX_DMA
+	// the packet is not modified until the end of the transmission,
+	// when glossy_end_tx completes the write
+	glossy_hal_radio_write_tx_start(packet, packet_len_tmp - 1);
+#else
+	glossy_hal_radio_write_tx(packet, packet_len_tmp - 1);
+#endif /* GLOSSY_TX_DMA */
+}
+
+/* ------------------------- Pipelined floods ----------------------- */
+static inline unsigned long slot_length_h(void) {
+	// full slot length (packet included), in DCO ticks
+	if (sync && T_slot_h) {
+		return (unsigned long)T_slot_h + (packet_len * F_CPU) / 31250;
+	} else {
+		return ((unsigned long)packet_len * 35 + 400) * 4;
+	}
+}
+
+static inline void load_packet(void) {
+	// set the packet length field to the appropriate value
+	GLOSSY_LEN_FIELD = packet_len_tmp;
+	// set the header field
+	GLOSSY_HEADER_FIELD = GLOSSY_HEADER | (header & ~GLOSSY_HEADER_MASK);
+	if (seq_len) {
+		// set the position of the packet in the stream
+		GLOSSY_SEQ_FIELD = seq | (seq_last ? GLOSSY_SEQ_LAST : 0);
+	}
+	// copy the application data to the data field
+	memcpy(&GLOSSY_DATA_FIELD, (uint8_t *)data + seq * data_len, data_len);
+}
+
+static inline uint8_t accept_seq(void) {
+	uint8_t rx_seq = GLOSSY_SEQ_FIELD & ~GLOSSY_SEQ_LAST;
+	if (rx_seq == seq && (seq_mask & (1 << seq))) {
+		// packet currently being flooded
+		return 1;
+	}
+	if (initiator || rx_seq < seq || rx_seq >= n_pkts) {
+		// older packet of the stream, or no room for it
+		return 0;
+	}
+	// first reception of a new packet of the stream
+	seq = rx_seq;
+	seq_last = GLOSSY_SEQ_FIELD & GLOSSY_SEQ_LAST;
+	tx_cnt = 0;
+	pkt_rx_cnt = 0;
+	return 1;
+}
+
+static inline void schedule_inject(void) {
+	// inject the next packet three slots after our last transmission:
+	// neighbors are then listening again and nodes two hops away have
+	// already finished relaying the current packet
+	inject = 1;
+	relay_cnt_base = tx_relay_cnt_last + 3;
+	glossy_hal_initiator_timeout_set(t_tx_stop + 2 * slot_length_h());
+}
+
+/* ------------------------ SFD and timeout handlers ---------------------- */
+static void glossy_unexpected(void) {
+	if (state != GLOSSY_STATE_OFF) {
+		// something strange is going on: go back to the waiting state
+		radio_flush_rx();
+		state = GLOSSY_STATE_WAITING;
+	}
+}
+
+static void sfd_waiting(void) {
+	if (glossy_hal_sfd_is_1()) {
+		// packet reception has started
+		glossy_begin_rx();
+	} else {
+		glossy_unexpected();
+	}
+}
+
+static void sfd_received(void) {
+	if (glossy_hal_sfd_is_1()) {
+		// packet transmission has started
+		glossy_begin_tx();
+	} else {
+		glossy_unexpected();
+	}
+}
+
+static void sfd_transmitting(void) {
+	if (!glossy_hal_sfd_is_1()) {
+		// packet transmission has finished
+		glossy_end_tx();
+	} else {
+		glossy_unexpected();
+	}
+}
+
+static void sfd_aborted(void) {
+	// packet reception has been aborted
+	state = GLOSSY_STATE_WAITING;
+}
+
+/**
+ * Handlers of the SFD edges, indexed by the state of Glossy.
+ * The end of a reception (falling edge in GLOSSY_STATE_RECEIVING) is handled
+ * directly by timerb1_interrupt, any other edge in that state is unexpected.
+ */
+static void (* const sfd_handler[])(void) = {
+	[GLOSSY_STATE_OFF]          = glossy_unexpected,
+	[GLOSSY_STATE_WAITING]      = sfd_waiting,
+	[GLOSSY_STATE_RECEIVING]    = glossy_unexpected,
+	[GLOSSY_STATE_RECEIVED]     = sfd_received,
+	[GLOSSY_STATE_TRANSMITTING] = sfd_transmitting,
+	[GLOSSY_STATE_TRANSMITTED]  = glossy_unexpected,
+	[GLOSSY_STATE_ABORTED]      = sfd_aborted,
+};
+
+static void initiator_timeout(void) {
+	if (state == GLOSSY_STATE_ABORTED) {
+		// the aborted reception is over
+		state = GLOSSY_STATE_WAITING;
+	}
+	if (state == GLOSSY_STATE_WAITING) {
+		n_timeouts++;
+		if (inject) {
+			// pipelined mode: move on to the next packet of the stream
+			inject = 0;
+			seq++;
+			seq_last = (seq == n_pkts - 1);
+			seq_mask |= 1 << seq;
+			n_timeouts = 0;
+			pkt_rx_cnt = 0;
+			t_start = glossy_hal_now_dco();
+		}
+		if (pkt_rx_cnt == 0) {
+			// no packets received so far: send the packet again
+			tx_cnt = 0;
+			load_packet();
+			if (sync) {
+				GLOSSY_RELAY_CNT_FIELD = relay_cnt_base + n_timeouts * GLOSSY_INITIATOR_TIMEOUT;
+			}
+			// set Glossy state
+			state = GLOSSY_STATE_RECEIVED;
+			// write the packet to the TXFIFO
+			radio_write_tx();
+			// start another transmission
+			radio_start_tx();
+			// schedule the timeout again
+			if ((!sync) || T_slot_h) {
+				glossy_schedule_initiator_timeout();
+			}
+		} else {
+			// at least one packet has been received: just stop the timeout
+			glossy_stop_initiator_timeout();
+		}
+	} else if (inject) {
+		// busy with an older packet: inject one slot later
+		relay_cnt_base++;
+		glossy_hal_initiator_timeout_set(glossy_hal_now_dco() + slot_length_h());
+	} else {
+		glossy_unexpected();
+	}
+}
+
+static void rx_timeout_expired(void) {
+	if (state == GLOSSY_STATE_RECEIVING) {
+		// we are still trying to receive a packet: abort the reception
+		radio_abort_rx();
+#if GLOSSY_DEBUG
+		rx_timeout++;
+#endif /* GLOSSY_DEBUG */
+	}
+	// stop the timeout
+	glossy_stop_rx_timeout();
 }
 
 /* --------------------------- SFD interrupt ------------------------ */
-interrupt(TIMERB1_VECTOR) __attribute__ ((section(".glossy")))
+interrupt(GLOSSY_HAL_SFD_VECTOR) __attribute__ ((section(".glossy")))
 timerb1_interrupt(void)
 {
 	// NOTE: if you modify the code if this function
-	// you may need to change the constant part of the interrupt delay (currently 21 DCO ticks),
-	// due to possible different compiler optimizations
+	// you may need to change the constant part of the interrupt delay (GLOSSY_IRQ_DELAY),
+	// due to possible different compiler optimizations; with GLOSSY_CALIBRATE_IRQ
+	// it is measured at startup (see glossy_calibrate_irq)
+	// constant part on the relay path (msp430 cycles): TBR is read 21 cycles
+	// after the SFD capture (15 after vector entry); STXON is written to
+	// U0TXBUF 56 cycles after that read in the listing of the original code,
+	// 52 with t_irq kept in a register (counted by hand, not yet from a listing)
 
 	// compute the variable part of the delay with which the interrupt has been served
-	T_irq = ((RTIMER_NOW_DCO() - TBCCR1) - 21) << 1;
+	rtimer_clock_t t_irq = ((glossy_hal_now_dco() - glossy_hal_sfd_time()) - irq_delay) << 1;
 
-	if (state == GLOSSY_STATE_RECEIVING && !SFD_IS_1) {
+	// fast path: the only work that depends on when the interrupt is served,
+	// tested before anything else
+	if (state == GLOSSY_STATE_RECEIVING && !glossy_hal_sfd_is_1()) {
 		// packet reception has finished
-		// T_irq in [0,...,8]
-		if (T_irq <= 8) {
+		// t_irq in [0,...,8]
+		if (t_irq <= 8) {
 			// NOPs (variable number) to compensate for the interrupt service delay (sec. 5.2)
-			asm volatile("add %[d], r0" : : [d] "m" (T_irq));
+#ifdef __MSP430__
+			asm volatile("add %[d], r0" : : [d] "r" (t_irq));
+#else
+			// host build (sky-sim): NOPs take no simulated time, charge the
+			// cycles of the 13 NOPs below that the jump would not skip
+			__delay_cycles(13 - (t_irq >> 1));
+#endif /* __MSP430__ */
 			asm volatile("nop");						// irq_delay = 0
 			asm volatile("nop");						// irq_delay = 2
 			asm volatile("nop");						// irq_delay = 4
@@ -164,89 +365,96 @@ timerb1_interrupt(void)
 			// relay the packet
 			radio_start_tx();
 			// read TBIV to clear IFG
-			tbiv = TBIV;
+			tbiv = glossy_hal_timer_iv();
 			glossy_end_rx();
 		} else {
 			// interrupt service delay is too high: do not relay the packet
 			radio_flush_rx();
 			state = GLOSSY_STATE_WAITING;
 			// read TBIV to clear IFG
-			tbiv = TBIV;
+			tbiv = glossy_hal_timer_iv();
+#if GLOSSY_DEBUG
+			high_T_irq++;
+#endif /* GLOSSY_DEBUG */
 		}
+		T_irq = t_irq;
 	} else {
-		// read TBIV to clear IFG
-		tbiv = TBIV;
-		if (state == GLOSSY_STATE_WAITING && SFD_IS_1) {
-			// packet reception has started
-			glossy_begin_rx();
+		T_irq = t_irq;
+		// read TBIV to clear IFG and dispatch on its source
+		tbiv = glossy_hal_timer_iv();
+		if (tbiv == GLOSSY_HAL_IV_INITIATOR_TIMEOUT) {
+			initiator_timeout();
+		} else if (tbiv == GLOSSY_HAL_IV_RX_TIMEOUT) {
+			rx_timeout_expired();
 		} else {
-			if (state == GLOSSY_STATE_RECEIVED && SFD_IS_1) {
-				// packet transmission has started
-				glossy_begin_tx();
-			} else {
-				if (state == GLOSSY_STATE_TRANSMITTING && !SFD_IS_1) {
-					// packet transmission has finished
-					glossy_end_tx();
-				} else {
-					if (state == GLOSSY_STATE_ABORTED) {
-						// packet reception has been aborted
-						state = GLOSSY_STATE_WAITING;
-					} else {
-						if ((state == GLOSSY_STATE_WAITING) && (tbiv == TBIV_TBCCR4)) {
-							// initiator timeout
-							n_timeouts++;
-							if (rx_cnt == 0) {
-								// no packets received so far: send the packet again
-								tx_cnt = 0;
-								// set the packet length field to the appropriate value
-								GLOSSY_LEN_FIELD = packet_len_tmp;
-								// set the header field
-								GLOSSY_HEADER_FIELD = GLOSSY_HEADER | (header & ~GLOSSY_HEADER_MASK);
-								if (sync) {
-									GLOSSY_RELAY_CNT_FIELD = n_timeouts * GLOSSY_INITIATOR_TIMEOUT;
-								}
-								// copy the application data to the data field
-								memcpy(&GLOSSY_DATA_FIELD, data, data_len);
-								// set Glossy state
-								state = GLOSSY_STATE_RECEIVED;
-								// write the packet to the TXFIFO
-								radio_write_tx();
-								// start another transmission
-								radio_start_tx();
-								// schedule the timeout again
-								glossy_schedule_initiator_timeout();
-							} else {
-								// at least one packet has been received: just stop the timeout
-								glossy_stop_initiator_timeout();
-							}
-						} else {
-							if (tbiv == TBIV_TBCCR5) {
-								// rx timeout
-								if (state == GLOSSY_STATE_RECEIVING) {
-									// we are still trying to receive a packet: abort the reception
-									radio_abort_rx();
-#if GLOSSY_DEBUG
-									rx_timeout++;
-#endif /* GLOSSY_DEBUG */
-								}
-								// stop the timeout
-								glossy_stop_rx_timeout();
-							} else {
-								if (state != GLOSSY_STATE_OFF) {
-									// something strange is going on: go back to the waiting state
-									radio_flush_rx();
-									state = GLOSSY_STATE_WAITING;
-								}
-							}
-						}
-					}
-				}
-			}
+			sfd_handler[state]();
 		}
 	}
+#if GLOSSY_LPM
+	if (state == GLOSSY_STATE_OFF) {
+		// the flood is over: wake glossy_process up to execute the callback
+		LPM4_EXIT;
+	}
+#endif /* GLOSSY_LPM */
+}
+
+#if GLOSSY_RX_CHUNK
+/* -------------------------- FIFOP interrupt ----------------------- */
+interrupt(GLOSSY_HAL_FIFOP_VECTOR) __attribute__ ((section(".glossy")))
+port1_interrupt(void)
+{
+	CLEAR_FIFOP_INT();
+	// read the packet being received in chunks, but leave at least the last
+	// 8 bytes to glossy_end_rx: this interrupt is then over well before the
+	// SFD falls at the end of the packet and cannot delay the relay
+	while (state == GLOSSY_STATE_RECEIVING && glossy_hal_fifop_is_1()
+			&& bytes_read + GLOSSY_RX_CHUNK <= packet_len_tmp - 7) {
+		glossy_hal_radio_read(&packet[bytes_read], GLOSSY_RX_CHUNK);
+		bytes_read += GLOSSY_RX_CHUNK;
+	}
 }
+#endif /* GLOSSY_RX_CHUNK */
 
 /* --------------------------- Glossy process ----------------------- */
+#if GLOSSY_LPM
+static void glossy_stop_wakeup(struct rtimer *t, void *ptr) {
+	// nothing to do: returning from the interrupt wakes glossy_process up
+}
+#endif /* GLOSSY_LPM */
+
+
+#if GLOSSY_CALIBRATE_IRQ
+/* ----------------------- IRQ delay calibration -------------------- */
+static void glossy_calibrate_irq(void) {
+	unsigned short tbctl, tbcctl1;
+
+	SFD_CAP_SW_TIMER_INIT(tbctl, tbcctl1);
+	// with a zero constant part, timerb1_interrupt stores the whole delay
+	// (state is OFF, so the interrupt does nothing else)
+	irq_delay = 0;
+	SFD_CAP_SW_INIT();
+	// irq_delay and T_irq are shared with the interrupt
+	asm volatile("" : : : "memory");
+	// the capture is taken at the end of the instruction that triggers it,
+	// and only NMIs and Timer B0 have priority over the SFD interrupt: it is
+	// served at the next instruction boundary, i.e., with the smallest delay
+	// of an SFD edge, which is the constant part (a single capture suffices)
+	SFD_CAP_SW_TRIGGER();
+	while (IS_PENDING_SFD_INT());
+	asm volatile("" : : : "memory");
+	irq_delay_measured = T_irq >> 1;
+	// an overestimate would make t_irq underflow in timerb1_interrupt, and
+	// any large error would make it drop all relays
+	if (irq_delay_measured + GLOSSY_IRQ_DELAY_RANGE < GLOSSY_IRQ_DELAY
+			|| irq_delay_measured > GLOSSY_IRQ_DELAY + GLOSSY_IRQ_DELAY_RANGE) {
+		irq_delay = GLOSSY_IRQ_DELAY;
+	} else {
+		irq_delay = irq_delay_measured;
+	}
+	SFD_CAP_SW_TIMER_RESTORE(tbctl, tbcctl1);
+}
+#endif /* GLOSSY_CALIBRATE_IRQ */
+
 PROCESS(glossy_process, "Glossy busy-waiting process");
 PROCESS_THREAD(glossy_process, ev, data) {
 	PROCESS_BEGIN();
@@ -254,11 +462,32 @@ PROCESS_THREAD(glossy_process, ev, data) {
 	do {
 		packet = (uint8_t *) malloc(128);
 	} while (packet == NULL);
+#if GLOSSY_CALIBRATE_IRQ
+	glossy_calibrate_irq();
+#endif /* GLOSSY_CALIBRATE_IRQ */
 
 	while (1) {
 		PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
 		// prevent the Contiki main cycle to enter the LPM mode or
 		// any other process to run while Glossy is running
+#if GLOSSY_LPM
+		if (stop_rtimer_set) {
+			// sleep in LPM0 (the DCO keeps clocking Timer B) until the flood
+			// is over or stop_rtimer fires at t_stop: the other interrupts of
+			// the flood are handled entirely in timerb1_interrupt
+			dint();
+			while (GLOSSY_IS_ON() && RTIMER_CLOCK_LT(RTIMER_NOW(), t_stop)) {
+				ENERGEST_OFF(ENERGEST_TYPE_CPU);
+				ENERGEST_ON(ENERGEST_TYPE_LPM);
+				// enable interrupts and sleep atomically
+				_BIS_SR(GIE | CPUOFF);
+				dint();
+				ENERGEST_OFF(ENERGEST_TYPE_LPM);
+				ENERGEST_ON(ENERGEST_TYPE_CPU);
+			}
+			eint();
+		}
+#endif /* GLOSSY_LPM */
 		while (GLOSSY_IS_ON() && RTIMER_CLOCK_LT(RTIMER_NOW(), t_stop));
 #if COOJA
 		while (state == GLOSSY_STATE_TRANSMITTING);
@@ -283,14 +512,30 @@ static inline void glossy_disable_other_interrupts(void) {
 	P1IE = 0;
 	P2IE = 0;
 	CACTL1 &= ~CAIE;
+	dma0ie = DMA0CTL & DMAIE;
+	dma1ie = DMA1CTL & DMAIE;
+	dma2ie = DMA2CTL & DMAIE;
 	DMA0CTL &= ~DMAIE;
 	DMA1CTL &= ~DMAIE;
 	DMA2CTL &= ~DMAIE;
-	// disable etimer interrupts
+	// hold UART1 transmission: a DMA-driven UART would otherwise steal
+	// cycles from the timing-critical code
+	me2 = ME2;
+	ME2 &= ~UTXE1;
+	// disable etimer interrupts and hold the count of Timer A overflows
+	// (a single overflow stays pending in TAIFG)
 	TACCTL1 &= ~CCIE;
+	taie = TACTL & TAIE;
+	TACTL &= ~TAIE;
 	TBCCTL0 = 0;
 	DISABLE_FIFOP_INT();
 	CLEAR_FIFOP_INT();
+#if GLOSSY_RX_CHUNK
+	// FIFOP rises as soon as a chunk of bytes is in the RXFIFO
+	glossy_hal_radio_set_fifop_threshold(GLOSSY_RX_CHUNK - 1);
+	FIFOP_INT_INIT();
+	ENABLE_FIFOP_INT();
+#endif /* GLOSSY_RX_CHUNK */
 	SFD_CAP_INIT(CM_BOTH);
 	ENABLE_SFD_INT();
 	// stop Timer B
@@ -309,8 +554,13 @@ static inline void glossy_enable_other_interrupts(void) {
 	IE2 = ie2;
 	P1IE = p1ie;
 	P2IE = p2ie;
+	DMA0CTL |= dma0ie;
+	DMA1CTL |= dma1ie;
+	DMA2CTL |= dma2ie;
+	ME2 = me2;
 	// enable etimer interrupts
 	TACCTL1 |= CCIE;
+	TACTL |= taie;
 #if COOJA
 	if (TACCTL1 & CCIFG) {
 		etimer_interrupt();
@@ -318,6 +568,10 @@ static inline void glossy_enable_other_interrupts(void) {
 #endif
 	DISABLE_SFD_INT();
 	CLEAR_SFD_INT();
+#if GLOSSY_RX_CHUNK
+	// back to the threshold used by the radio driver
+	glossy_hal_radio_set_fifop_threshold(127);
+#endif /* GLOSSY_RX_CHUNK */
 	FIFOP_INT_INIT();
 	ENABLE_FIFOP_INT();
 	// stop Timer B
@@ -331,13 +585,15 @@ static inline void glossy_enable_other_interrupts(void) {
 }
 
 /* --------------------------- Main interface ----------------------- */
-void glossy_start(glossy_data_struct *data_, uint8_t data_len_, uint8_t initiator_,
-		uint8_t sync_, uint8_t tx_max_, uint8_t header_,
+static void glossy_start_phase(glossy_data_struct *data_, uint8_t data_len_, uint8_t n_pkts_,
+		uint8_t seq_len_, uint8_t initiator_, uint8_t sync_, uint8_t tx_max_, uint8_t header_,
 		rtimer_clock_t t_stop_, rtimer_callback_t cb_,
 		struct rtimer *rtimer_, void *ptr_) {
 	// copy function arguments to the respective Glossy variables
 	data = data_;
 	data_len = data_len_;
+	n_pkts = (n_pkts_ > GLOSSY_PIPELINE_MAX) ? GLOSSY_PIPELINE_MAX : (n_pkts_ ? n_pkts_ : 1);
+	seq_len = seq_len_;
 	initiator = initiator_;
 	sync = sync_;
 	tx_max = tx_max_;
@@ -351,13 +607,20 @@ void glossy_start(glossy_data_struct *data_, uint8_t data_len_, uint8_t initiato
 	// initialize Glossy variables
 	tx_cnt = 0;
 	rx_cnt = 0;
+	seq = 0;
+	pkt_rx_cnt = 0;
+	inject = 0;
+	relay_cnt_base = 0;
+	// without sequence numbers the only packet is also the last one
+	seq_last = (seq_len == 0) || (initiator && n_pkts == 1);
+	seq_mask = (initiator) ? 1 : 0;
 
-	t_start = RTIMER_NOW_DCO();
+	t_start = glossy_hal_now_dco();
 	// set Glossy packet length, with or without relay counter depending on the sync flag value
 	if (data_len) {
 		packet_len_tmp = (sync) ?
-				data_len + FOOTER_LEN + GLOSSY_RELAY_CNT_LEN + GLOSSY_HEADER_LEN :
-				data_len + FOOTER_LEN + GLOSSY_HEADER_LEN;
+				data_len + seq_len + FOOTER_LEN + GLOSSY_RELAY_CNT_LEN + GLOSSY_HEADER_LEN :
+				data_len + seq_len + FOOTER_LEN + GLOSSY_HEADER_LEN;
 		packet_len = packet_len_tmp;
 		// set the packet length field to the appropriate value
 		GLOSSY_LEN_FIELD = packet_len_tmp;
@@ -369,7 +632,7 @@ void glossy_start(glossy_data_struct *data_, uint8_t data_len_, uint8_t initiato
 	}
 	if (initiator) {
 		// initiator: copy the application data to the data field
-		memcpy(&GLOSSY_DATA_FIELD, data, data_len);
+		load_packet();
 		// set Glossy state
 		state = GLOSSY_STATE_RECEIVED;
 	} else {
@@ -405,10 +668,31 @@ void glossy_start(glossy_data_struct *data_, uint8_t data_len_, uint8_t initiato
 		// turn on the radio
 		radio_on();
 	}
+#if GLOSSY_LPM
+	// wake the CPU up at t_stop (timera0 exits the low-power mode after
+	// running any real-time task); if t_stop is too close, busy-wait
+	stop_rtimer_set = (rtimer_set(&stop_rtimer, t_stop, 1, glossy_stop_wakeup, NULL) == RTIMER_OK);
+#endif /* GLOSSY_LPM */
 	// activate the Glossy busy waiting process
 	process_poll(&glossy_process);
 }
 
+void glossy_start(glossy_data_struct *data_, uint8_t data_len_, uint8_t initiator_,
+		uint8_t sync_, uint8_t tx_max_, uint8_t header_,
+		rtimer_clock_t t_stop_, rtimer_callback_t cb_,
+		struct rtimer *rtimer_, void *ptr_) {
+	glossy_start_phase(data_, data_len_, 1, 0, initiator_, sync_, tx_max_, header_,
+			t_stop_, cb_, rtimer_, ptr_);
+}
+
+void glossy_start_pipeline(glossy_data_struct *data_, uint8_t data_len_, uint8_t n_pkts_,
+		uint8_t initiator_, uint8_t sync_, uint8_t tx_max_, uint8_t header_,
+		rtimer_clock_t t_stop_, rtimer_callback_t cb_,
+		struct rtimer *rtimer_, void *ptr_) {
+	glossy_start_phase(data_, data_len_, n_pkts_, GLOSSY_SEQ_LEN, initiator_, sync_, tx_max_, header_,
+			t_stop_, cb_, rtimer_, ptr_);
+}
+
 uint8_t glossy_stop(void) {
 	// stop the initiator timeout, in case it is still active
 	glossy_stop_initiator_timeout();
@@ -422,6 +706,11 @@ uint8_t glossy_stop(void) {
 	state = GLOSSY_STATE_OFF;
 	// re-enable non Glossy-related interrupts
 	glossy_enable_other_interrupts();
+	if (t_ref_l_updated) {
+		// extend the new reference time, which is less than 2^16 ticks old
+		rtimer_long_clock_t now = RTIMER_NOW_LONG();
+		t_ref_l_long = now - (rtimer_clock_t)((rtimer_clock_t)now - t_ref_l);
+	}
 	// return the number of times the packet has been received
 	return rx_cnt;
 }
@@ -430,6 +719,18 @@ uint8_t get_rx_cnt(void) {
 	return rx_cnt;
 }
 
+uint8_t get_irq_delay(void) {
+	return irq_delay_measured;
+}
+
+uint8_t get_seq_mask(void) {
+	return seq_mask;
+}
+
+uint8_t get_data_len(void) {
+	return data_len;
+}
+
 uint8_t get_relay_cnt(void) {
 	return relay_cnt;
 }
@@ -450,10 +751,20 @@ rtimer_clock_t get_t_ref_l(void) {
 	return t_ref_l;
 }
 
+rtimer_long_clock_t get_t_ref_l_long(void) {
+	return t_ref_l_long;
+}
+
 void set_t_ref_l(rtimer_clock_t t) {
+	t_ref_l_long += (rtimer_clock_t)(t - t_ref_l);
 	t_ref_l = t;
 }
 
+void set_t_ref_l_long(rtimer_long_clock_t t) {
+	t_ref_l_long = t;
+	t_ref_l = (rtimer_clock_t)t;
+}
+
 void set_t_ref_l_updated(uint8_t updated) {
 	t_ref_l_updated = updated;
 }
@@ -494,7 +805,7 @@ static inline void estimate_slot_length(rtimer_clock_t t_rx_stop_tmp) {
 static inline void compute_sync_reference_time(void) {
 #if COOJA
 	rtimer_clock_t t_cap_l = RTIMER_NOW();
-	rtimer_clock_t t_cap_h = RTIMER_NOW_DCO();
+	rtimer_clock_t t_cap_h = glossy_hal_now_dco();
 #else
 	// capture the next low-frequency clock tick
 	rtimer_clock_t t_cap_h, t_cap_l;
@@ -514,7 +825,7 @@ static inline void compute_sync_reference_time(void) {
 
 /* ----------------------- Interrupt functions ---------------------- */
 inline void glossy_begin_rx(void) {
-	t_rx_start = TBCCR1;
+	t_rx_start = glossy_hal_sfd_time();
 	state = GLOSSY_STATE_RECEIVING;
 	if (packet_len) {
 		// Rx timeout: packet duration + 200 us
@@ -523,8 +834,8 @@ inline void glossy_begin_rx(void) {
 	}
 
 	// wait until the FIFO pin is 1 (i.e., until the first byte is received)
-	while (!FIFO_IS_1) {
-		if (packet_len && !RTIMER_CLOCK_LT(RTIMER_NOW_DCO(), t_rx_timeout)) {
+	while (!glossy_hal_fifo_is_1()) {
+		if (packet_len && !RTIMER_CLOCK_LT(glossy_hal_now_dco(), t_rx_timeout)) {
 			radio_abort_rx();
 #if GLOSSY_DEBUG
 			rx_timeout++;
@@ -533,7 +844,7 @@ inline void glossy_begin_rx(void) {
 		}
 	};
 	// read the first byte (i.e., the len field) from the RXFIFO
-	FASTSPI_READ_FIFO_BYTE(GLOSSY_LEN_FIELD);
+	GLOSSY_LEN_FIELD = glossy_hal_radio_read_byte();
 	// keep receiving only if it has the right length
 	if ((packet_len && (GLOSSY_LEN_FIELD != packet_len_tmp))
 			|| (GLOSSY_LEN_FIELD < FOOTER_LEN) || (GLOSSY_LEN_FIELD > 127)) {
@@ -552,8 +863,8 @@ inline void glossy_begin_rx(void) {
 
 #if !COOJA
 	// wait until the FIFO pin is 1 (i.e., until the second byte is received)
-	while (!FIFO_IS_1) {
-		if (!RTIMER_CLOCK_LT(RTIMER_NOW_DCO(), t_rx_timeout)) {
+	while (!glossy_hal_fifo_is_1()) {
+		if (!RTIMER_CLOCK_LT(glossy_hal_now_dco(), t_rx_timeout)) {
 			radio_abort_rx();
 #if GLOSSY_DEBUG
 			rx_timeout++;
@@ -562,7 +873,7 @@ inline void glossy_begin_rx(void) {
 		}
 	};
 	// read the second byte (i.e., the header field) from the RXFIFO
-	FASTSPI_READ_FIFO_BYTE(GLOSSY_HEADER_FIELD);
+	GLOSSY_HEADER_FIELD = glossy_hal_radio_read_byte();
 	// keep receiving only if it has the right header
 	if ((GLOSSY_HEADER_FIELD & GLOSSY_HEADER_MASK) != GLOSSY_HEADER) {
 		// packet with a wrong header: abort packet reception
@@ -573,12 +884,13 @@ inline void glossy_begin_rx(void) {
 		return;
 	}
 	bytes_read = 2;
+#if !GLOSSY_RX_CHUNK
 	if (packet_len_tmp > 8) {
 		// if packet is longer than 8 bytes, read all bytes but the last 8
 		while (bytes_read <= packet_len_tmp - 8) {
 			// wait until the FIFO pin is 1 (until one more byte is received)
-			while (!FIFO_IS_1) {
-				if (!RTIMER_CLOCK_LT(RTIMER_NOW_DCO(), t_rx_timeout)) {
+			while (!glossy_hal_fifo_is_1()) {
+				if (!RTIMER_CLOCK_LT(glossy_hal_now_dco(), t_rx_timeout)) {
 					radio_abort_rx();
 #if GLOSSY_DEBUG
 					rx_timeout++;
@@ -587,24 +899,31 @@ inline void glossy_begin_rx(void) {
 				}
 			};
 			// read another byte from the RXFIFO
-			FASTSPI_READ_FIFO_BYTE(packet[bytes_read]);
+			packet[bytes_read] = glossy_hal_radio_read_byte();
 			bytes_read++;
 		}
 	}
+#endif /* GLOSSY_RX_CHUNK */
 #endif /* COOJA */
 	glossy_schedule_rx_timeout();
 }
 
 inline void glossy_end_rx(void) {
-	rtimer_clock_t t_rx_stop_tmp = TBCCR1;
+	rtimer_clock_t t_rx_stop_tmp = glossy_hal_sfd_time();
 	// read the remaining bytes from the RXFIFO
-	FASTSPI_READ_FIFO_NO_WAIT(&packet[bytes_read], packet_len_tmp - bytes_read + 1);
+	glossy_hal_radio_read(&packet[bytes_read], packet_len_tmp - bytes_read + 1);
 	bytes_read = packet_len_tmp + 1;
 #if COOJA
 	if ((GLOSSY_CRC_FIELD & FOOTER1_CRC_OK) && ((GLOSSY_HEADER_FIELD & GLOSSY_HEADER_MASK) == GLOSSY_HEADER)) {
 #else
 	if (GLOSSY_CRC_FIELD & FOOTER1_CRC_OK) {
 #endif /* COOJA */
+		if (seq_len && !accept_seq()) {
+			// older packet of the stream: do not relay it
+			radio_abort_tx();
+			state = GLOSSY_STATE_WAITING;
+			return;
+		}
 		header = GLOSSY_HEADER_FIELD & ~GLOSSY_HEADER_MASK;
 		// packet correctly received
 		if (sync) {
@@ -612,12 +931,18 @@ inline void glossy_end_rx(void) {
 			GLOSSY_RELAY_CNT_FIELD++;
 		}
 		if (tx_cnt == tx_max) {
-			// no more Tx to perform: stop Glossy
-			radio_off();
-			state = GLOSSY_STATE_OFF;
+			if (seq_last) {
+				// no more Tx to perform: stop Glossy
+				radio_off();
+				state = GLOSSY_STATE_OFF;
+			} else {
+				// done with this packet: wait for the next one of the stream
+				radio_abort_tx();
+				state = GLOSSY_STATE_WAITING;
+			}
 		} else {
-			// write Glossy packet to the TXFIFO
-			radio_write_tx();
+			// write Glossy packet to the TXFIFO (still being calibrated)
+			radio_write_tx_start();
 			state = GLOSSY_STATE_RECEIVED;
 		}
 		if (rx_cnt == 0) {
@@ -629,19 +954,21 @@ inline void glossy_end_rx(void) {
 			}
 		}
 		rx_cnt++;
+		pkt_rx_cnt++;
+		seq_mask |= 1 << seq;
 		if (sync) {
 			estimate_slot_length(t_rx_stop_tmp);
 		}
 		t_rx_stop = t_rx_stop_tmp;
-		if (initiator) {
+		if (initiator && !inject) {
 			// a packet has been successfully received: stop the initiator timeout
 			glossy_stop_initiator_timeout();
 		}
 		if (!packet_len) {
 			packet_len = packet_len_tmp;
 			data_len = (sync) ?
-					packet_len_tmp - FOOTER_LEN - GLOSSY_RELAY_CNT_LEN - GLOSSY_HEADER_LEN :
-					packet_len_tmp - FOOTER_LEN - GLOSSY_HEADER_LEN;
+					packet_len_tmp - seq_len - FOOTER_LEN - GLOSSY_RELAY_CNT_LEN - GLOSSY_HEADER_LEN :
+					packet_len_tmp - seq_len - FOOTER_LEN - GLOSSY_HEADER_LEN;
 		}
 	} else {
 #if GLOSSY_DEBUG
@@ -654,12 +981,12 @@ inline void glossy_end_rx(void) {
 }
 
 inline void glossy_begin_tx(void) {
-	t_tx_start = TBCCR1;
+	t_tx_start = glossy_hal_sfd_time();
 	state = GLOSSY_STATE_TRANSMITTING;
 	tx_relay_cnt_last = GLOSSY_RELAY_CNT_FIELD;
-	if ((!initiator) && (rx_cnt == 1)) {
+	if ((!initiator) && (pkt_rx_cnt == 1)) {
 		// copy the application data from the data field
-		memcpy(data, &GLOSSY_DATA_FIELD, data_len);
+		memcpy((uint8_t *)data + seq * data_len, &GLOSSY_DATA_FIELD, data_len);
 	}
 	if ((sync) && (T_slot_h) && (!t_ref_l_updated) && (rx_cnt)) {
 		// compute the reference time after the first reception (higher accuracy)
@@ -670,39 +997,36 @@ inline void glossy_begin_tx(void) {
 inline void glossy_end_tx(void) {
 	ENERGEST_OFF(ENERGEST_TYPE_TRANSMIT);
 	ENERGEST_ON(ENERGEST_TYPE_LISTEN);
-	t_tx_stop = TBCCR1;
+	t_tx_stop = glossy_hal_sfd_time();
 	// stop Glossy if tx_cnt reached tx_max (and tx_max > 1 at the initiator)
-	if ((++tx_cnt == tx_max) && ((tx_max - initiator) > 0)) {
+	// and there are no more packets in the stream
+	if ((++tx_cnt == tx_max) && seq_last && ((tx_max - initiator) > 0)) {
 		radio_off();
 		state = GLOSSY_STATE_OFF;
 	} else {
 		state = GLOSSY_STATE_WAITING;
+		if (initiator && (tx_cnt == tx_max) && !seq_last) {
+			schedule_inject();
+		}
 	}
 	radio_flush_tx();
 }
 
 /* ------------------------------ Timeouts -------------------------- */
 inline void glossy_schedule_rx_timeout(void) {
-	TBCCR5 = t_rx_timeout;
-	TBCCTL5 = CCIE;
+	glossy_hal_rx_timeout_set(t_rx_timeout);
 }
 
 inline void glossy_stop_rx_timeout(void) {
-	TBCCTL5 = 0;
+	glossy_hal_rx_timeout_stop();
 }
 
 inline void glossy_schedule_initiator_timeout(void) {
 #if !COOJA
-	if (sync) {
-		TBCCR4 = t_start + (n_timeouts + 1) * GLOSSY_INITIATOR_TIMEOUT * ((unsigned long)T_slot_h + (packet_len * F_CPU) / 31250);
-	} else {
-		TBCCR4 = t_start + (n_timeouts + 1) * GLOSSY_INITIATOR_TIMEOUT *
-				((rtimer_clock_t)packet_len * 35 + 400) * 4;
-	}
-	TBCCTL4 = CCIE;
+	glossy_hal_initiator_timeout_set(t_start + (n_timeouts + 1) * GLOSSY_INITIATOR_TIMEOUT * slot_length_h());
 #endif
 }
 
 inline void glossy_stop_initiator_timeout(void) {
-	TBCCTL4 = 0;
+	glossy_hal_initiator_timeout_stop();
 }
@@ -42,9 +42,8 @@
 
 #include "contiki.h"
 #include "dev/watchdog.h"
-#include "dev/cc2420_const.h"
 #include "dev/leds.h"
-#include "dev/spi.h"
+#include "dev/glossy-hal.h"
 #include <stdio.h>
 #include <legacymsp430.h>
 #include <stdlib.h>
@@ -67,6 +66,97 @@
  */
 #define GLOSSY_INITIATOR_TIMEOUT      3
 
+/**
+ * Maximum number of packets flooded back-to-back in a single Glossy phase
+ * (see \link glossy_start_pipeline \endlink).
+ */
+#define GLOSSY_PIPELINE_MAX           8
+
+/**
+ * If not zero, the CPU sleeps in LPM0 during a Glossy phase instead of
+ * busy-waiting in \link glossy_process \endlink. The DCO keeps running
+ * Timer B, so the SFD and timeout interrupts are served as before, and
+ * a real-time task at t_stop wakes the CPU up to run the callback.
+ */
+#ifdef GLOSSY_CONF_LPM
+#define GLOSSY_LPM                    GLOSSY_CONF_LPM
+#else /* GLOSSY_CONF_LPM */
+#define GLOSSY_LPM                    0
+#endif /* GLOSSY_CONF_LPM */
+
+/**
+ * If not zero, the bytes of a packet being received are read from the
+ * RXFIFO in chunks of this many bytes by the FIFOP interrupt, whose
+ * threshold is set accordingly during a Glossy phase, instead of one by
+ * one while spinning in the SFD interrupt. The last 8 bytes or more are
+ * still read at the end of the packet. Ignored with COOJA.
+ */
+#ifdef GLOSSY_CONF_RX_CHUNK
+#define GLOSSY_RX_CHUNK               GLOSSY_CONF_RX_CHUNK
+#else /* GLOSSY_CONF_RX_CHUNK */
+#define GLOSSY_RX_CHUNK               0
+#endif /* GLOSSY_CONF_RX_CHUNK */
+
+#if GLOSSY_RX_CHUNK > 8
+#error "GLOSSY_RX_CHUNK must not exceed 8"
+#endif
+
+/**
+ * If not zero, a received packet is copied to the TXFIFO for the relay
+ * in the background (by DMA where the platform supports it, see
+ * glossy_hal_radio_write_tx_start()), so the SFD interrupt returns
+ * while the bytes are still being written. Ignored with COOJA.
+ */
+#ifdef GLOSSY_CONF_TX_DMA
+#define GLOSSY_TX_DMA                 GLOSSY_CONF_TX_DMA
+#else /* GLOSSY_CONF_TX_DMA */
+#define GLOSSY_TX_DMA                 0
+#endif /* GLOSSY_CONF_TX_DMA */
+
+/**
+ * Constant part of the delay, in DCO ticks, between an SFD edge and the
+ * instant at which timerb1_interrupt reads the timer. It depends on the
+ * compiler and on the code of the interrupt: this is the value expected
+ * for this build.
+ */
+#ifdef GLOSSY_CONF_IRQ_DELAY
+#define GLOSSY_IRQ_DELAY              GLOSSY_CONF_IRQ_DELAY
+#else /* GLOSSY_CONF_IRQ_DELAY */
+#define GLOSSY_IRQ_DELAY              21
+#endif /* GLOSSY_CONF_IRQ_DELAY */
+
+/**
+ * If not zero, glossy_process measures the constant part of the SFD
+ * interrupt delay when it starts, with a capture triggered by software on
+ * the SFD capture register, and uses it instead of
+ * \link GLOSSY_IRQ_DELAY \endlink if it is within
+ * \link GLOSSY_IRQ_DELAY_RANGE \endlink ticks of it.
+ * \sa get_irq_delay
+ */
+#ifdef GLOSSY_CONF_CALIBRATE_IRQ
+#define GLOSSY_CALIBRATE_IRQ          GLOSSY_CONF_CALIBRATE_IRQ
+#else /* GLOSSY_CONF_CALIBRATE_IRQ */
+#define GLOSSY_CALIBRATE_IRQ          0
+#endif /* GLOSSY_CONF_CALIBRATE_IRQ */
+
+/**
+ * Largest difference, in DCO ticks, between the measured constant part of
+ * the SFD interrupt delay and \link GLOSSY_IRQ_DELAY \endlink for the
+ * measurement to be used: the variable part compensated in
+ * timerb1_interrupt spans as many ticks. Outside this range relays would
+ * be dropped anyway, so \link GLOSSY_IRQ_DELAY \endlink is kept.
+ */
+#define GLOSSY_IRQ_DELAY_RANGE        4
+
+#if COOJA
+#undef GLOSSY_CALIBRATE_IRQ
+#define GLOSSY_CALIBRATE_IRQ          0
+#undef GLOSSY_RX_CHUNK
+#define GLOSSY_RX_CHUNK               0
+#undef GLOSSY_TX_DMA
+#define GLOSSY_TX_DMA                 0
+#endif /* COOJA */
+
 /**
  * Ratio between the frequencies of the DCO and the low-frequency clocks
  */
@@ -80,6 +170,8 @@
 #define GLOSSY_HEADER_MASK            0xf0
 #define GLOSSY_HEADER_LEN             sizeof(uint8_t)
 #define GLOSSY_RELAY_CNT_LEN          sizeof(uint8_t)
+#define GLOSSY_SEQ_LEN                sizeof(uint8_t)
+#define GLOSSY_SEQ_LAST               0x80
 #define GLOSSY_IS_ON()                (get_state() != GLOSSY_STATE_OFF)
 #define FOOTER_LEN                    2
 #define FOOTER1_CRC_OK                0x80
@@ -87,7 +179,8 @@
 
 #define GLOSSY_LEN_FIELD              packet[0]
 #define GLOSSY_HEADER_FIELD           packet[1]
-#define GLOSSY_DATA_FIELD             packet[2]
+#define GLOSSY_SEQ_FIELD              packet[2]
+#define GLOSSY_DATA_FIELD             packet[2 + seq_len]
 #define GLOSSY_RELAY_CNT_FIELD        packet[packet_len_tmp - FOOTER_LEN]
 #define GLOSSY_RSSI_FIELD             packet[packet_len_tmp - 1]
 #define GLOSSY_CRC_FIELD              packet[packet_len_tmp]
@@ -165,6 +258,33 @@ void glossy_start(glossy_data_struct* data_, uint8_t data_len_, uint8_t initiato
 		rtimer_clock_t t_stop_, rtimer_callback_t cb_,
 		struct rtimer *rtimer_, void *ptr_);
 
+/**
+ * \brief            Start Glossy in pipelined mode: flood up to
+ *                   \link GLOSSY_PIPELINE_MAX \endlink packets back-to-back
+ *                   in the same Glossy phase.
+ *
+ *                   Each packet carries a sequence number (position in the
+ *                   stream) after the header field. The initiator injects
+ *                   packet i+1 three slots after its last transmission of
+ *                   packet i, while relays further away are still forwarding
+ *                   packet i. Relays switch to a packet as soon as they
+ *                   receive it and ignore packets older than the current one.
+ *
+ * \param data_      A pointer to an array of \p n_pkts_ data structures,
+ *                   one per packet of the stream.
+ * \param data_len_  Length of the data of each packet, in bytes.
+ * \param n_pkts_    At the initiator, number of packets to flood.
+ *                   At a receiver, number of entries available in \p data_.
+ *
+ *                   The other parameters are the same as in
+ *                   \link glossy_start \endlink.
+ * \sa               get_seq_mask
+ */
+void glossy_start_pipeline(glossy_data_struct* data_, uint8_t data_len_, uint8_t n_pkts_,
+		uint8_t initiator_, uint8_t sync_, uint8_t tx_max_, uint8_t header_,
+		rtimer_clock_t t_stop_, rtimer_callback_t cb_,
+		struct rtimer *rtimer_, void *ptr_);
+
 /**
  * \brief            Stop Glossy and resume all other application tasks.
  * \returns          Number of times the packet has been received during
@@ -182,6 +302,34 @@ uint8_t glossy_stop(void);
  */
 uint8_t get_rx_cnt(void);
 
+/**
+ * \brief            Get the constant part of the SFD interrupt delay.
+ * \returns          Delay in DCO ticks measured at startup with
+ *                   \link GLOSSY_CALIBRATE_IRQ \endlink (even if it was
+ *                   out of range and not used), or
+ *                   \link GLOSSY_IRQ_DELAY \endlink. A measured value that
+ *                   differs from \link GLOSSY_IRQ_DELAY \endlink means that
+ *                   the interrupt code has changed since it was tuned.
+ */
+uint8_t get_irq_delay(void);
+
+/**
+ * \brief            Get the packets of the stream received during the last
+ *                   Glossy phase.
+ * \returns          Bit i is set if packet i has been received
+ *                   (at the initiator: if packet i has been transmitted).
+ *                   Always 1 after a successful non-pipelined flood.
+ */
+uint8_t get_seq_mask(void);
+
+/**
+ * \brief            Get the length of the flooding data.
+ * \returns          Length of the data of each packet, in bytes.
+ *                   At a receiver started with zero data length, this is
+ *                   learned from the first packet received.
+ */
+uint8_t get_data_len(void);
+
 /**
  * \brief            Get the current Glossy state.
  * \return           Current Glossy state, one of the possible values
@@ -224,6 +372,14 @@ rtimer_clock_t get_T_slot_h(void);
  */
 rtimer_clock_t get_t_ref_l(void);
 
+/**
+ * \brief            Get low-frequency synchronization reference time on the
+ *                   extended clock (see RTIMER_NOW_LONG()).
+ * \returns          Low-frequency reference time, without the 2 s wraparound
+ *                   of \link get_t_ref_l \endlink.
+ */
+rtimer_long_clock_t get_t_ref_l_long(void);
+
 /**
  * \brief            Provide information about current synchronization status.
  * \returns          Not zero if the synchronization reference time was
@@ -239,6 +395,16 @@ uint8_t is_t_ref_l_updated(void);
  */
 void set_t_ref_l(rtimer_clock_t t);
 
+/**
+ * \brief            Set low-frequency synchronization reference time on the
+ *                   extended clock.
+ * \param t          Updated reference time.
+ *
+ *                   \link set_t_ref_l \endlink only moves the reference
+ *                   forward by less than 2^16 ticks; this sets it to any time.
+ */
+void set_t_ref_l_long(rtimer_long_clock_t t);
+
 /**
  * \brief            Set the current synchronization status.
  * \param updated    Not zero if a node has to be considered synchronized,
@@ -283,72 +449,6 @@ inline void glossy_end_tx(void);
 
 /** @} */
 
-/**
- * \defgroup glossy_capture Timer capture of clock ticks
- * @{
- */
-
-/* -------------------------- Clock Capture ------------------------- */
-/**
- * \brief Capture next low-frequency clock tick and DCO clock value at that instant.
- * \param t_cap_h variable for storing value of DCO clock value
- * \param t_cap_l variable for storing value of low-frequency clock value
- */
-#define CAPTURE_NEXT_CLOCK_TICK(t_cap_h, t_cap_l) do {\
-		/* Enable capture mode for timers B6 and A2 (ACLK) */\
-		TBCCTL6 = CCIS0 | CM_POS | CAP | SCS; \
-		TACCTL2 = CCIS0 | CM_POS | CAP | SCS; \
-		/* Wait until both timers capture the next clock tick */\
-		while (!((TBCCTL6 & CCIFG) && (TACCTL2 & CCIFG))); \
-		/* Store the capture timer values */\
-		t_cap_h = TBCCR6; \
-		t_cap_l = TACCR2; \
-		/* Disable capture mode */\
-		TBCCTL6 = 0; \
-		TACCTL2 = 0; \
-} while (0)
-
-/** @} */
-
-/* -------------------------------- SFD ----------------------------- */
-
-/**
- * \defgroup glossy_sfd Management of SFD interrupts
- * @{
- */
-
-/**
- * \brief Capture instants of SFD events on timer B1
- * \param edge Edge used for capture.
- *
- */
-#define SFD_CAP_INIT(edge) do {\
-	P4SEL |= BV(SFD);\
-	TBCCTL1 = edge | CAP | SCS;\
-} while (0)
-
-/**
- * \brief Enable generation of interrupts due to SFD events
- */
-#define ENABLE_SFD_INT()		do { TBCCTL1 |= CCIE; } while (0)
-
-/**
- * \brief Disable generation of interrupts due to SFD events
- */
-#define DISABLE_SFD_INT()		do { TBCCTL1 &= ~CCIE; } while (0)
-
-/**
- * \brief Clear interrupt flag due to SFD events
- */
-#define CLEAR_SFD_INT()			do { TBCCTL1 &= ~CCIFG; } while (0)
-
-/**
- * \brief Check if generation of interrupts due to SFD events is enabled
- */
-#define IS_ENABLED_SFD_INT()    !!(TBCCTL1 & CCIE)
-
-/** @} */
-
 #endif /* GLOSSY_H_ */
 
 /** @} */
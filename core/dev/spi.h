@@ -203,6 +203,36 @@ void spi_init(void);
 
 
 
+#ifdef SPI_DMA_WRITE
+/*
+ * TXFIFO write by DMA, for platforms that define SPI_DMA_WRITE(p,c)
+ * (start a DMA block of c bytes from p to SPI_TXBUF, triggered by the
+ * TX buffer becoming empty) and SPI_DMA_BUSY().
+ * FASTSPI_WRITE_FIFO_DMA returns as soon as the command byte is written
+ * and leaves CSn low while the DMA moves the bytes: p must not change
+ * until FASTSPI_DMA_END(), which waits for the transfer and releases the
+ * bus. Call FASTSPI_DMA_END() before any other access to the bus; it
+ * does nothing if no transfer is pending.
+ */
+#define FASTSPI_WRITE_FIFO_DMA(p,c)\
+	do {\
+		SPI_ENABLE();\
+		SPI_DMA_WRITE(p,c);\
+		SPI_TXBUF = CC2420_TXFIFO;\
+	} while (0)
+
+#define FASTSPI_DMA_END()\
+	do {\
+		if (SPI_IS_ENABLED()) {\
+			while (SPI_DMA_BUSY());\
+			SPI_WAITFORTx_ENDED();\
+			SPI_DISABLE();\
+		}\
+	} while (0)
+#endif /* SPI_DMA_WRITE */
+
+
+
 /***********************************************************
 	FAST SPI: CC2420 RAM access (big or little-endian order)
 ***********************************************************/
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Single-producer/single-consumer ring of fixed-size elements,
+ *         implementation
+ */
+
+#include <string.h>
+
+#include "spscring.h"
+
+/* Prevent the compiler from moving element copies across index updates. */
+#define BARRIER() __asm__ __volatile__("" : : : "memory")
+/*---------------------------------------------------------------------------*/
+void
+spscring_init(struct spscring *r, void *a, uint8_t elem_size, uint8_t size)
+{
+  r->data = a;
+  r->elem_size = elem_size;
+  r->mask = size - 1;
+  r->put_ptr = 0;
+  r->get_ptr = 0;
+  r->overflows = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+spscring_put(struct spscring *r, const void *e)
+{
+  uint8_t put = r->put_ptr;
+
+  if((uint8_t)(put - r->get_ptr) > r->mask) {
+    r->overflows++;
+    return 0;
+  }
+  memcpy(r->data + (put & r->mask) * r->elem_size, e, r->elem_size);
+  /* Publish the element only once it has been copied. */
+  BARRIER();
+  r->put_ptr = put + 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+spscring_get(struct spscring *r, void *e)
+{
+  uint8_t get = r->get_ptr;
+
+  if(r->put_ptr == get) {
+    return 0;
+  }
+  memcpy(e, r->data + (get & r->mask) * r->elem_size, r->elem_size);
+  /* Release the slot only once the element has been copied. */
+  BARRIER();
+  r->get_ptr = get + 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+spscring_put_bulk(struct spscring *r, const void *e, uint8_t n)
+{
+  uint8_t put = r->put_ptr;
+  uint8_t space = r->mask + 1 - (uint8_t)(put - r->get_ptr);
+  uint8_t i;
+
+  if(n > space) {
+    r->overflows += n - space;
+    n = space;
+  }
+  for(i = 0; i < n; i++, put++) {
+    memcpy(r->data + (put & r->mask) * r->elem_size,
+           (const uint8_t *)e + i * r->elem_size, r->elem_size);
+  }
+  BARRIER();
+  r->put_ptr = put;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+spscring_get_bulk(struct spscring *r, void *e, uint8_t n)
+{
+  uint8_t get = r->get_ptr;
+  uint8_t avail = r->put_ptr - get;
+  uint8_t i;
+
+  if(n > avail) {
+    n = avail;
+  }
+  for(i = 0; i < n; i++, get++) {
+    memcpy((uint8_t *)e + i * r->elem_size,
+           r->data + (get & r->mask) * r->elem_size, r->elem_size);
+  }
+  BARRIER();
+  r->get_ptr = get;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
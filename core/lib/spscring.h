@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for the single-producer/single-consumer ring
+ *         of fixed-size elements
+ */
+
+#ifndef __SPSCRING_H__
+#define __SPSCRING_H__
+
+#include "contiki-conf.h"
+
+/**
+ * \brief      Structure that holds the state of an SPSC ring.
+ *
+ *             The ring stores elements of a fixed size in an external
+ *             array. One context (e.g., a process) may put elements
+ *             while another one (e.g., an interrupt handler) gets
+ *             them, without disabling interrupts: the put index is
+ *             only written by the producer and the get index only by
+ *             the consumer. Both are free-running 8-bit counters, so
+ *             all elements of the array can be used and accesses to
+ *             them are atomic.
+ *
+ */
+struct spscring {
+  uint8_t *data;
+  uint8_t elem_size;
+  uint8_t mask;
+
+  volatile uint8_t put_ptr, get_ptr;
+
+  /** Number of elements that could not be put because the ring was full. */
+  unsigned short overflows;
+};
+
+/**
+ * \brief      Initialize an SPSC ring
+ * \param r    A pointer to a struct spscring to hold the state of the ring
+ * \param a    A pointer to an array of size_power_of_two elements
+ * \param elem_size The size of an element, in bytes
+ * \param size_power_of_two The number of elements in the ring, which
+ *             must be a power of two and cannot be larger than 128
+ */
+void    spscring_init(struct spscring *r, void *a, uint8_t elem_size,
+                      uint8_t size_power_of_two);
+
+/**
+ * \brief      Put an element into the ring
+ * \param r    A pointer to the ring
+ * \param e    A pointer to the element to be copied into the ring
+ * \return     Non-zero if the element was inserted, zero if the ring was
+ *             full (the overflow counter is then incremented).
+ *
+ *             Must only be called by the producer.
+ */
+int     spscring_put(struct spscring *r, const void *e);
+
+/**
+ * \brief      Get an element from the ring
+ * \param r    A pointer to the ring
+ * \param e    A pointer to the memory where the element is copied
+ * \return     Non-zero if an element was removed, zero if the ring was
+ *             empty.
+ *
+ *             Must only be called by the consumer.
+ */
+int     spscring_get(struct spscring *r, void *e);
+
+/**
+ * \brief      Put several elements into the ring
+ * \param r    A pointer to the ring
+ * \param e    A pointer to an array of n elements
+ * \param n    The number of elements to put
+ * \return     The number of elements inserted. Elements that did not
+ *             fit are added to the overflow counter.
+ */
+int     spscring_put_bulk(struct spscring *r, const void *e, uint8_t n);
+
+/**
+ * \brief      Get several elements from the ring
+ * \param r    A pointer to the ring
+ * \param e    A pointer to the memory where up to n elements are copied,
+ *             back to back
+ * \param n    The maximum number of elements to get
+ * \return     The number of elements removed.
+ */
+int     spscring_get_bulk(struct spscring *r, void *e, uint8_t n);
+
+/**
+ * \brief      Get the size of an SPSC ring
+ * \param r    A pointer to the ring
+ * \return     The maximum number of elements in the ring.
+ */
+#define spscring_size(r)     ((r)->mask + 1)
+
+/**
+ * \brief      Get the number of elements currently in the ring
+ * \param r    A pointer to the ring
+ * \return     The number of elements in the ring.
+ */
+#define spscring_elements(r) ((uint8_t)((r)->put_ptr - (r)->get_ptr))
+
+#endif /* __SPSCRING_H__ */
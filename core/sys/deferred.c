@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \file
+ *         Deferred calls from interrupt handlers, implementation
+ */
+
+#include "sys/deferred.h"
+#include "lib/spscring.h"
+
+struct call {
+  deferred_callback_t f;
+  void *arg;
+};
+
+static struct call calls[DEFERRED_SIZE];
+static struct spscring queue;
+/*---------------------------------------------------------------------------*/
+void
+deferred_init(void)
+{
+  spscring_init(&queue, calls, sizeof(struct call), DEFERRED_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+int
+deferred_call(deferred_callback_t f, void *arg)
+{
+  struct call c;
+
+  c.f = f;
+  c.arg = arg;
+  return spscring_put(&queue, &c);
+}
+/*---------------------------------------------------------------------------*/
+int
+deferred_run(void)
+{
+  struct call c;
+  int n = 0;
+
+  while(spscring_get(&queue, &c)) {
+    c.f(c.arg);
+    n++;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+deferred_pending(void)
+{
+  return spscring_elements(&queue) != 0;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+deferred_overflows(void)
+{
+  return queue.overflows;
+}
+/*---------------------------------------------------------------------------*/
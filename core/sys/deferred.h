@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ */
+
+/**
+ * \addtogroup sys
+ * @{
+ */
+
+/**
+ * \defgroup deferred Deferred calls from interrupt handlers
+ *
+ * Interrupt handlers queue a function and its argument with
+ * deferred_call() instead of doing the work themselves; the main loop
+ * runs the queued calls with deferred_run() before it runs processes.
+ * This keeps interrupt bodies short, so that the interrupts that must
+ * be served on time (e.g., the SFD capture used by Glossy) are not
+ * delayed by work that can wait.
+ *
+ * The queue is an SPSC ring (see spscring.h): interrupt handlers do not
+ * nest on the MSP430, so they act as a single producer, and the main
+ * loop is the only consumer. Neither side disables interrupts.
+ *
+ * @{
+ */
+
+/**
+ * \file
+ *         Header file for the deferred calls from interrupt handlers
+ */
+
+#ifndef __DEFERRED_H__
+#define __DEFERRED_H__
+
+#include "contiki-conf.h"
+
+/**
+ * Number of calls that can be queued (a power of two, at most 128).
+ */
+#ifdef DEFERRED_CONF_SIZE
+#define DEFERRED_SIZE DEFERRED_CONF_SIZE
+#else /* DEFERRED_CONF_SIZE */
+#define DEFERRED_SIZE 16
+#endif /* DEFERRED_CONF_SIZE */
+
+typedef void (* deferred_callback_t)(void *arg);
+
+/**
+ * Initialize the queue of deferred calls.
+ */
+void deferred_init(void);
+
+/**
+ * \brief      Queue a call to run from the main loop
+ * \param f    The function to call
+ * \param arg  The argument passed to the function
+ * \return     Non-zero if the call was queued, zero if the queue was full.
+ *
+ *             Must be called from an interrupt handler, or from the main
+ *             loop with interrupts disabled. The caller should wake the
+ *             CPU up (LPM4_EXIT) so that the call runs before the next
+ *             sleep.
+ */
+int deferred_call(deferred_callback_t f, void *arg);
+
+/**
+ * \brief      Run the queued calls
+ * \return     The number of calls run.
+ *
+ *             Called by the main loop. Calls queued while it runs are
+ *             run as well.
+ */
+int deferred_run(void);
+
+/**
+ * \brief      Check whether calls are waiting to be run
+ */
+int deferred_pending(void);
+
+/**
+ * Number of calls dropped because the queue was full.
+ */
+unsigned short deferred_overflows(void);
+
+#endif /* __DEFERRED_H__ */
+
+/** @} */
+/** @} */
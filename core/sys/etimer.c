@@ -50,95 +50,306 @@
 #include "sys/etimer.h"
 #include "sys/process.h"
 
-static struct etimer *timerlist;
+/*
+ * Pending timers are kept in a hashed timing wheel: a timer expiring at
+ * time t is on the unsorted list of slot t % WHEEL_SLOTS, so that it is
+ * inserted in constant time. etimer_process walks the slots of the ticks
+ * elapsed since its last run and moves the expired timers to the overdue
+ * list, which is ordered by expiration time.
+ */
+#ifdef ETIMER_CONF_WHEEL_SLOTS
+#define WHEEL_SLOTS ETIMER_CONF_WHEEL_SLOTS
+#else /* ETIMER_CONF_WHEEL_SLOTS */
+#define WHEEL_SLOTS 32
+#endif /* ETIMER_CONF_WHEEL_SLOTS */
+
+#if (WHEEL_SLOTS & (WHEEL_SLOTS - 1)) != 0
+#error ETIMER_CONF_WHEEL_SLOTS must be a power of two.
+#endif
+
+#define SLOT(time) ((unsigned)(time) & (WHEEL_SLOTS - 1))
+
+static struct etimer *wheel[WHEEL_SLOTS];
+/* Expired timers not yet posted, ordered by expiration time. */
+static struct etimer *overdue;
+/* Last time whose slot has been walked: the timers on the wheel expire
+   after it. */
+static clock_time_t cursor;
+static unsigned int pending;
+/* Earliest expiration time, or earlier when that timer has been
+   stopped or moved (a poll then finds nothing to do and updates it). */
 static clock_time_t next_expiration;
 
 PROCESS(etimer_process, "Event timer");
+
+/* Expiration time of a timer. */
+#define EXPIRATION(t) ((t)->timer.start + (t)->timer.interval)
+/* Check if time a is before time b, taking wraps into account. */
+#define BEFORE(a, b) ((clock_time_t)((a) - (b)) > (~(clock_time_t)0) / 2)
 /*---------------------------------------------------------------------------*/
 static void
 update_time(void)
 {
-  clock_time_t tdist;
-  clock_time_t now;
+#if CLOCK_CONF_TICKLESS
+  /* Let the clock program its next interrupt. */
+  etimer_interrupt();
+#endif /* CLOCK_CONF_TICKLESS */
+}
+/*---------------------------------------------------------------------------*/
+/* Remove a timer from a list. Return non-zero if it was on the list. */
+static int
+unlink_from(struct etimer **tp, struct etimer *timer)
+{
+  for(; *tp != NULL; tp = &(*tp)->next) {
+    if(*tp == timer) {
+      *tp = timer->next;
+      timer->next = NULL;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Remove a pending timer, before its expiration time changes. Return
+   non-zero if it was pending. */
+static int
+unlink_timer(struct etimer *timer)
+{
+  if(timer->p == PROCESS_NONE) {
+    return 0;
+  }
+  if(unlink_from(&wheel[SLOT(EXPIRATION(timer))], timer) ||
+     unlink_from(&overdue, timer)) {
+    pending--;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Insert a timer in the overdue list, after all the timers that do not
+   expire later. */
+static void
+insert_overdue(struct etimer *timer)
+{
+  struct etimer **tp;
+  clock_time_t expiration = EXPIRATION(timer);
+
+  for(tp = &overdue; *tp != NULL; tp = &(*tp)->next) {
+    if(BEFORE(expiration, EXPIRATION(*tp))) {
+      break;
+    }
+  }
+  timer->next = *tp;
+  *tp = timer;
+}
+/*---------------------------------------------------------------------------*/
+static void
+insert_timer(struct etimer *timer)
+{
+  clock_time_t expiration = EXPIRATION(timer);
+
+  if(BEFORE(cursor, expiration)) {
+    timer->next = wheel[SLOT(expiration)];
+    wheel[SLOT(expiration)] = timer;
+  } else {
+    /* Its slot has already been walked. */
+    insert_overdue(timer);
+  }
+  if(pending++ == 0 || BEFORE(expiration, next_expiration)) {
+    next_expiration = expiration;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Merge two lists ordered by expiration time; timers of a go first
+   among those with the same expiration time. */
+static struct etimer *
+merge_timers(struct etimer *a, struct etimer *b)
+{
+  struct etimer *list, **tp = &list;
+
+  while(a != NULL && b != NULL) {
+    if(BEFORE(EXPIRATION(b), EXPIRATION(a))) {
+      *tp = b;
+      b = b->next;
+    } else {
+      *tp = a;
+      a = a->next;
+    }
+    tp = &(*tp)->next;
+  }
+  *tp = a != NULL ? a : b;
+  return list;
+}
+/*---------------------------------------------------------------------------*/
+/* Order a list by expiration time (merge sort, stable). */
+static struct etimer *
+sort_timers(struct etimer *list)
+{
+  struct etimer *slow, *fast, *half;
+
+  if(list == NULL || list->next == NULL) {
+    return list;
+  }
+  slow = list;
+  fast = list->next;
+  while(fast != NULL && fast->next != NULL) {
+    slow = slow->next;
+    fast = fast->next->next;
+  }
+  half = slow->next;
+  slow->next = NULL;
+  return merge_timers(sort_timers(list), sort_timers(half));
+}
+/*---------------------------------------------------------------------------*/
+/* Move the timers of a slot that expire at or before time to the end
+   of a list, *tail; return the new end. */
+static struct etimer **
+take_expired(struct etimer **tp, clock_time_t time, struct etimer **tail)
+{
+  struct etimer *t, *expired = NULL;
+
+  while(*tp != NULL) {
+    t = *tp;
+    if(BEFORE(time, EXPIRATION(t))) {
+      tp = &t->next;
+    } else {
+      *tp = t->next;
+      t->next = expired;
+      expired = t;
+    }
+  }
+  /* The slot lists the latest timers first: reversed, timers with the
+     same expiration time are in the order in which they were set. */
+  for(*tail = expired; *tail != NULL; tail = &(*tail)->next);
+  return tail;
+}
+/*---------------------------------------------------------------------------*/
+/* Move the timers that have expired by now to the overdue list. */
+static void
+advance_wheel(clock_time_t now)
+{
+  struct etimer *expired = NULL, **tail = &expired;
+  unsigned int i;
+
+  if((clock_time_t)(now - cursor) >= WHEEL_SLOTS) {
+    /* A whole turn has elapsed (e.g., a long sleep): sweep every slot,
+       which may hold timers of several turns. */
+    for(i = 1; i <= WHEEL_SLOTS; i++) {
+      tail = take_expired(&wheel[SLOT(cursor + i)], now, tail);
+    }
+    expired = sort_timers(expired);
+  } else {
+    /* Within a turn, the expired timers of a slot all expire at its
+       time: walking the slots in order sorts them. */
+    while(cursor != now) {
+      cursor++;
+      tail = take_expired(&wheel[SLOT(cursor)], cursor, tail);
+    }
+  }
+  cursor = now;
+  overdue = merge_timers(overdue, expired);
+}
+/*---------------------------------------------------------------------------*/
+static void
+find_next_expiration(void)
+{
   struct etimer *t;
+  clock_time_t time;
+  unsigned int i;
 
-  if (timerlist == NULL) {
+  if(overdue != NULL) {
+    next_expiration = EXPIRATION(overdue);
+    return;
+  }
+  if(pending == 0) {
     next_expiration = 0;
-  } else {
-    now = clock_time();
-    t = timerlist;
-    /* Must calculate distance to next time into account due to wraps */
-    tdist = t->timer.start + t->timer.interval - now;
-    for(t = t->next; t != NULL; t = t->next) {
-      if(t->timer.start + t->timer.interval - now < tdist) {
-	tdist = t->timer.start + t->timer.interval - now;
+    return;
+  }
+  /* The first slot with a timer expiring in the next turn. */
+  for(i = 1; i <= WHEEL_SLOTS; i++) {
+    time = cursor + i;
+    for(t = wheel[SLOT(time)]; t != NULL; t = t->next) {
+      if(EXPIRATION(t) == time) {
+        next_expiration = time;
+        return;
+      }
+    }
+  }
+  /* All timers expire later: take the one closest to the cursor. */
+  next_expiration = cursor - 1;
+  for(i = 0; i < WHEEL_SLOTS; i++) {
+    for(t = wheel[i]; t != NULL; t = t->next) {
+      if((clock_time_t)(EXPIRATION(t) - cursor) <
+         (clock_time_t)(next_expiration - cursor)) {
+        next_expiration = EXPIRATION(t);
       }
     }
-    next_expiration = now + tdist;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Remove the timers of an exited process from a list. */
+static void
+remove_process(struct etimer **tp, struct process *p)
+{
+  while(*tp != NULL) {
+    if((*tp)->p == p) {
+      *tp = (*tp)->next;
+      pending--;
+    } else {
+      tp = &(*tp)->next;
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
 {
-  struct etimer *t, *u;
-	
+  struct etimer *t;
+  unsigned int i;
+
   PROCESS_BEGIN();
 
-  timerlist = NULL;
-  
+  for(i = 0; i < WHEEL_SLOTS; i++) {
+    wheel[i] = NULL;
+  }
+  overdue = NULL;
+  pending = 0;
+  cursor = clock_time();
+
   while(1) {
     PROCESS_YIELD();
 
     if(ev == PROCESS_EVENT_EXITED) {
-      struct process *p = data;
-
-      while(timerlist != NULL && timerlist->p == p) {
-	timerlist = timerlist->next;
-      }
-
-      if(timerlist != NULL) {
-	t = timerlist;
-	while(t->next != NULL) {
-	  if(t->next->p == p) {
-	    t->next = t->next->next;
-	  } else
-	    t = t->next;
-	}
+      for(i = 0; i < WHEEL_SLOTS; i++) {
+        remove_process(&wheel[i], data);
       }
+      remove_process(&overdue, data);
+      find_next_expiration();
+      update_time();
       continue;
     } else if(ev != PROCESS_EVENT_POLL) {
       continue;
     }
 
-  again:
-    
-    u = NULL;
-    
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(timer_expired(&t->timer)) {
-	if(process_post(t->p, PROCESS_EVENT_TIMER, t) == PROCESS_ERR_OK) {
-	  
-	  /* Reset the process ID of the event timer, to signal that the
-	     etimer has expired. This is later checked in the
-	     etimer_expired() function. */
-	  t->p = PROCESS_NONE;
-	  if(u != NULL) {
-	    u->next = t->next;
-	  } else {
-	    timerlist = t->next;
-	  }
-	  t->next = NULL;
-	  update_time();
-	  goto again;
-	} else {
-	  etimer_request_poll();
-	}
+    advance_wheel(clock_time());
+    while(overdue != NULL) {
+      t = overdue;
+      if(process_post(t->p, PROCESS_EVENT_TIMER, t) != PROCESS_ERR_OK) {
+	/* The event queue is full, try again when it has room. */
+	process_request_space(&etimer_process);
+	break;
       }
-      u = t;
+      /* Reset the process ID of the event timer, to signal that the
+	 etimer has expired. This is later checked in the
+	 etimer_expired() function. */
+      t->p = PROCESS_NONE;
+      overdue = t->next;
+      t->next = NULL;
+      pending--;
     }
-    
+    find_next_expiration();
+    update_time();
   }
-  
+
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
@@ -148,28 +359,17 @@ etimer_request_poll(void)
   process_poll(&etimer_process);
 }
 /*---------------------------------------------------------------------------*/
+/* Insert a timer whose expiration time has been set; one that was
+   pending (taken off with unlink_timer) keeps its process. */
 static void
-add_timer(struct etimer *timer)
+add_timer(struct etimer *timer, int was_pending)
 {
-  struct etimer *t;
-
   etimer_request_poll();
 
-  if(timer->p != PROCESS_NONE) {
-    /* Timer not on list. */
-    
-    for(t = timerlist; t != NULL; t = t->next) {
-      if(t == timer) {
-	/* Timer already on list, bail out. */
-	update_time();
-	return;
-      }
-    }
+  if(!was_pending) {
+    timer->p = PROCESS_CURRENT();
   }
-
-  timer->p = PROCESS_CURRENT();
-  timer->next = timerlist;
-  timerlist = timer;
+  insert_timer(timer);
 
   update_time();
 }
@@ -177,29 +377,40 @@ add_timer(struct etimer *timer)
 void
 etimer_set(struct etimer *et, clock_time_t interval)
 {
+  int was_pending = unlink_timer(et);
+
   timer_set(&et->timer, interval);
-  add_timer(et);
+  add_timer(et, was_pending);
 }
 /*---------------------------------------------------------------------------*/
 void
 etimer_reset(struct etimer *et)
 {
+  int was_pending = unlink_timer(et);
+
   timer_reset(&et->timer);
-  add_timer(et);
+  add_timer(et, was_pending);
 }
 /*---------------------------------------------------------------------------*/
 void
 etimer_restart(struct etimer *et)
 {
+  int was_pending = unlink_timer(et);
+
   timer_restart(&et->timer);
-  add_timer(et);
+  add_timer(et, was_pending);
 }
 /*---------------------------------------------------------------------------*/
 void
 etimer_adjust(struct etimer *et, int timediff)
 {
+  int was_pending = unlink_timer(et);
+
   et->timer.start += timediff;
-  update_time();
+  if(was_pending) {
+    insert_timer(et);
+    update_time();
+  }
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -223,7 +434,7 @@ etimer_start_time(struct etimer *et)
 int
 etimer_pending(void)
 {
-  return timerlist != NULL;
+  return pending != 0;
 }
 /*---------------------------------------------------------------------------*/
 clock_time_t
@@ -235,29 +446,9 @@ etimer_next_expiration_time(void)
 void
 etimer_stop(struct etimer *et)
 {
-  struct etimer *t;
-
-  /* First check if et is the first event timer on the list. */
-  if(et == timerlist) {
-    timerlist = timerlist->next;
-    update_time();
-  } else {
-    /* Else walk through the list and try to find the item before the
-       et timer. */
-    for(t = timerlist; t != NULL && t->next != et; t = t->next);
-
-    if(t != NULL) {
-      /* We've found the item before the event timer that we are about
-	 to remove. We point the items next pointer to the event after
-	 the removed item. */
-      t->next = et->next;
-
-      update_time();
-    }
-  }
+  /* The next expiration time is updated on the next poll. */
+  unlink_timer(et);
 
-  /* Remove the next pointer from the item to be removed. */
-  et->next = NULL;
   /* Set the timer as expired */
   et->p = PROCESS_NONE;
 }
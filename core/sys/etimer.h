@@ -229,7 +229,10 @@ int etimer_pending(void);
  *	       returns 0.
  *
  *             This functions returns next expiration time of all
- *             pending event timers.
+ *             pending event timers. After a pending timer has been
+ *             stopped or set again, it may return an earlier time until
+ *             etimer_process next runs: the clock then wakes it up once
+ *             more than needed.
  */
 clock_time_t etimer_next_expiration_time(void);
 
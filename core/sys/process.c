@@ -48,6 +48,9 @@
 
 #include "sys/process.h"
 #include "sys/arg.h"
+#if PROCESS_PROFILE
+#include "sys/rtimer.h"
+#endif /* PROCESS_PROFILE */
 
 /*
  * Pointer to the currently running process structure.
@@ -64,16 +67,67 @@ struct event_data {
   process_event_t ev;
   process_data_t data;
   struct process *p;
+  process_num_events_t next;
 };
 
-static process_num_events_t nevents, fevent;
+#if PROCESS_CONF_NUMEVENTS > 254
+#error PROCESS_CONF_NUMEVENTS must be at most 254.
+#endif
+
+/* End of a list of events. */
+#define EVENT_NONE ((process_num_events_t)~0)
+
+/*
+ * Pool of events shared by the event queues, so that a burst of events
+ * to processes of one priority can use all of it. Free entries are
+ * linked from free_event.
+ */
 static struct event_data events[PROCESS_CONF_NUMEVENTS];
+static process_num_events_t free_event, nevents;
+
+/*
+ * Queues of events, one per priority level. Events posted to a
+ * high-priority process go to the high-priority queue.
+ */
+struct event_queue {
+  process_num_events_t head, tail, nevents;
+};
+
+static struct event_queue queues[PROCESS_PRIO_LEVELS];
+
+/* Non-zero if a process waits for a free entry in the pool. */
+static unsigned char space_requested;
 
 #if PROCESS_CONF_STATS
 process_num_events_t process_maxevents;
+unsigned short process_fullevents, process_coalesced;
 #endif
 
-static volatile unsigned char poll_requested;
+/*
+ * Processes that requested to be polled, in order of request, one list
+ * per priority level. The lists are changed with interrupts disabled,
+ * since process_poll() may be called from interrupt handlers.
+ */
+static struct process * volatile poll_head[PROCESS_PRIO_LEVELS];
+static struct process *poll_tail[PROCESS_PRIO_LEVELS];
+
+#define poll_requested(prio) (poll_head[prio] != NULL)
+#define any_poll_requested() (poll_requested(PROCESS_PRIO_NORMAL) || \
+                              poll_requested(PROCESS_PRIO_HIGH))
+
+/*
+ * Number of consecutive runs in which high-priority work was handled
+ * while normal-priority work was waiting.
+ */
+static unsigned char starved;
+
+#if PROCESS_PROFILE
+/*
+ * Ticks spent in processes called from the running one (for example
+ * with process_post_synch()), not to be charged to it.
+ */
+static rtimer_clock_t profile_nested;
+#endif /* PROCESS_PROFILE */
 
 #define PROCESS_STATE_NONE        0
 #define PROCESS_STATE_RUNNING     1
@@ -169,6 +223,9 @@ static void
 call_process(struct process *p, process_event_t ev, process_data_t data)
 {
   int ret;
+#if PROCESS_PROFILE
+  rtimer_clock_t start, elapsed, nested;
+#endif /* PROCESS_PROFILE */
 
 #if DEBUG
   if(p->state == PROCESS_STATE_CALLED) {
@@ -181,7 +238,21 @@ call_process(struct process *p, process_event_t ev, process_data_t data)
     PRINTF("process: calling process '%s' with event %d\n", p->name, ev);
     process_current = p;
     p->state = PROCESS_STATE_CALLED;
+#if PROCESS_PROFILE
+    nested = profile_nested;
+    profile_nested = 0;
+    start = RTIMER_NOW();
+#endif /* PROCESS_PROFILE */
     ret = p->thread(&p->pt, ev, data);
+#if PROCESS_PROFILE
+    elapsed = RTIMER_NOW() - start;
+    p->prof_calls++;
+    p->prof_ticks += (rtimer_clock_t)(elapsed - profile_nested);
+    if((rtimer_clock_t)(elapsed - profile_nested) > p->prof_max) {
+      p->prof_max = elapsed - profile_nested;
+    }
+    profile_nested = nested + elapsed;
+#endif /* PROCESS_PROFILE */
     if(ret == PT_EXITED ||
        ret == PT_ENDED ||
        ev == PROCESS_EVENT_EXIT) {
@@ -201,11 +272,26 @@ process_exit(struct process *p)
 void
 process_init(void)
 {
+  int i;
+
   lastevent = PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  for(i = 0; i < PROCESS_CONF_NUMEVENTS; i++) {
+    events[i].next = i + 1 < PROCESS_CONF_NUMEVENTS ? i + 1 : EVENT_NONE;
+  }
+  free_event = 0;
+  nevents = 0;
+  space_requested = 0;
+
+  for(i = 0; i < PROCESS_PRIO_LEVELS; i++) {
+    queues[i].head = queues[i].tail = EVENT_NONE;
+    queues[i].nevents = 0;
+    poll_head[i] = poll_tail[i] = NULL;
+  }
+  starved = 0;
 #if PROCESS_CONF_STATS
   process_maxevents = 0;
+  process_fullevents = process_coalesced = 0;
 #endif /* PROCESS_CONF_STATS */
 
   process_current = process_list = NULL;
@@ -216,17 +302,45 @@ process_init(void)
  */
 /*---------------------------------------------------------------------------*/
 static void
-do_poll(void)
+do_poll(unsigned char prio)
+{
+  struct process *p, *next;
+  int s;
+
+  /* Take the list of processes that need to be polled. Polls requested
+     from now on go to a new list. */
+  s = splhigh();
+  p = poll_head[prio];
+  poll_head[prio] = poll_tail[prio] = NULL;
+  splx(s);
+
+  /* Call them. */
+  for(; p != NULL; p = next) {
+    next = p->nextpoll;
+    p->needspoll = 0;
+    if(p->state != PROCESS_STATE_NONE) {
+#if PROCESS_CONF_STATS
+      p->npolls++;
+#endif /* PROCESS_CONF_STATS */
+      p->state = PROCESS_STATE_RUNNING;
+      call_process(p, PROCESS_EVENT_POLL, NULL);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Poll the processes that wait for a free entry in the event pool.
+ */
+static void
+notify_space(void)
 {
   struct process *p;
 
-  poll_requested = 0;
-  /* Call the processes that needs to be polled. */
+  space_requested = 0;
   for(p = process_list; p != NULL; p = p->next) {
-    if(p->needspoll) {
-      p->state = PROCESS_STATE_RUNNING;
-      p->needspoll = 0;
-      call_process(p, PROCESS_EVENT_POLL, NULL);
+    if(p->waitspace) {
+      p->waitspace = 0;
+      process_poll(p);
     }
   }
 }
@@ -237,12 +351,13 @@ do_poll(void)
  */
 /*---------------------------------------------------------------------------*/
 static void
-do_event(void)
+do_event(struct event_queue *q)
 {
   static process_event_t ev;
   static process_data_t data;
   static struct process *receiver;
   static struct process *p;
+  process_num_events_t i;
   
   /*
    * If there are any events in the queue, take the first one and walk
@@ -252,19 +367,30 @@ do_event(void)
    * call the poll handlers inbetween.
    */
 
-  if(nevents > 0) {
+  if(q->nevents > 0) {
     
     /* There are events that we should deliver. */
-    ev = events[fevent].ev;
+    i = q->head;
+    ev = events[i].ev;
     
-    data = events[fevent].data;
-    receiver = events[fevent].p;
-
-    /* Since we have seen the new event, we move pointer upwards
-       and decrese the number of events. */
-    fevent = (fevent + 1) % PROCESS_CONF_NUMEVENTS;
+    data = events[i].data;
+    receiver = events[i].p;
+
+    /* Since we have seen the new event, we remove it from the queue,
+       return it to the pool and decrese the number of events. */
+    q->head = events[i].next;
+    if(q->head == EVENT_NONE) {
+      q->tail = EVENT_NONE;
+    }
+    --q->nevents;
+    events[i].next = free_event;
+    free_event = i;
     --nevents;
 
+    if(space_requested) {
+      notify_space();
+    }
+
     /* If this is a broadcast event, we deliver it to all events, in
        order of their priority. */
     if(receiver == PROCESS_BROADCAST) {
@@ -272,8 +398,11 @@ do_event(void)
 
 	/* If we have been requested to poll a process, we do this in
 	   between processing the broadcast event. */
-	if(poll_requested) {
-	  do_poll();
+	if(poll_requested(PROCESS_PRIO_HIGH)) {
+	  do_poll(PROCESS_PRIO_HIGH);
+	}
+	if(poll_requested(PROCESS_PRIO_NORMAL)) {
+	  do_poll(PROCESS_PRIO_NORMAL);
 	}
 	call_process(p, ev, data);
       }
@@ -295,27 +424,49 @@ do_event(void)
 int
 process_run(void)
 {
-  /* Process poll events. */
-  if(poll_requested) {
-    do_poll();
+  /* High-priority polls are always handled first. */
+  if(poll_requested(PROCESS_PRIO_HIGH)) {
+    do_poll(PROCESS_PRIO_HIGH);
   }
 
-  /* Process one event from the queue */
-  do_event();
+  if(queues[PROCESS_PRIO_HIGH].nevents > 0 &&
+     starved < PROCESS_STARVATION_LIMIT) {
+    /* Process one high-priority event, and count it if normal-priority
+       work had to wait for it. */
+    if(poll_requested(PROCESS_PRIO_NORMAL) ||
+       queues[PROCESS_PRIO_NORMAL].nevents > 0) {
+      starved++;
+    }
+    do_event(&queues[PROCESS_PRIO_HIGH]);
+  } else {
+    starved = 0;
+
+    /* Process poll events. */
+    if(poll_requested(PROCESS_PRIO_NORMAL)) {
+      do_poll(PROCESS_PRIO_NORMAL);
+    }
+
+    /* Process one event from the queue */
+    do_event(&queues[PROCESS_PRIO_NORMAL]);
+  }
 
-  return nevents + poll_requested;
+  return nevents + any_poll_requested();
 }
 /*---------------------------------------------------------------------------*/
 int
 process_nevents(void)
 {
-  return nevents + poll_requested;
+  return nevents + any_poll_requested();
 }
 /*---------------------------------------------------------------------------*/
 int
 process_post(struct process *p, process_event_t ev, process_data_t data)
 {
   static process_num_events_t snum;
+  struct event_queue *q;
+#if PROCESS_COALESCE
+  process_num_events_t i;
+#endif /* PROCESS_COALESCE */
 
   if(PROCESS_CURRENT() == NULL) {
     PRINTF("process_post: NULL process posts event %d to process '%s', nevents %d\n",
@@ -326,7 +477,25 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
 	   p == PROCESS_BROADCAST? "<broadcast>": p->name, nevents);
   }
   
-  if(nevents == PROCESS_CONF_NUMEVENTS) {
+  q = &queues[p == PROCESS_BROADCAST ? PROCESS_PRIO_NORMAL : p->prio];
+
+#if PROCESS_COALESCE
+  /* An event that is still waiting to be delivered is not queued
+     twice. */
+  for(i = q->head; i != EVENT_NONE; i = events[i].next) {
+    if(events[i].p == p && events[i].ev == ev && events[i].data == data) {
+#if PROCESS_CONF_STATS
+      process_coalesced++;
+#endif /* PROCESS_CONF_STATS */
+      return PROCESS_ERR_OK;
+    }
+  }
+#endif /* PROCESS_COALESCE */
+
+  if(free_event == EVENT_NONE) {
+#if PROCESS_CONF_STATS
+    process_fullevents++;
+#endif /* PROCESS_CONF_STATS */
 #if DEBUG
     if(p == PROCESS_BROADCAST) {
       printf("soft panic: event queue is full when broadcast event %d was posted from %s\n", ev, process_current->name);
@@ -337,10 +506,19 @@ process_post(struct process *p, process_event_t ev, process_data_t data)
     return PROCESS_ERR_FULL;
   }
   
-  snum = (process_num_events_t)(fevent + nevents) % PROCESS_CONF_NUMEVENTS;
+  snum = free_event;
+  free_event = events[snum].next;
   events[snum].ev = ev;
   events[snum].data = data;
   events[snum].p = p;
+  events[snum].next = EVENT_NONE;
+  if(q->tail == EVENT_NONE) {
+    q->head = snum;
+  } else {
+    events[q->tail].next = snum;
+  }
+  q->tail = snum;
+  ++q->nevents;
   ++nevents;
 
 #if PROCESS_CONF_STATS
@@ -364,15 +542,68 @@ process_post_synch(struct process *p, process_event_t ev, process_data_t data)
 void
 process_poll(struct process *p)
 {
+  int s;
+
   if(p != NULL) {
     if(p->state == PROCESS_STATE_RUNNING ||
        p->state == PROCESS_STATE_CALLED) {
-      p->needspoll = 1;
-      poll_requested = 1;
+      s = splhigh();
+      if(!p->needspoll) {
+	/* Not on the poll list yet. */
+	p->needspoll = 1;
+	p->nextpoll = NULL;
+	if(poll_head[p->prio] == NULL) {
+	  poll_head[p->prio] = p;
+	} else {
+	  poll_tail[p->prio]->nextpoll = p;
+	}
+	poll_tail[p->prio] = p;
+      }
+      splx(s);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+process_request_space(struct process *p)
+{
+  if(free_event != EVENT_NONE) {
+    /* There is room already. */
+    process_poll(p);
+  } else {
+    p->waitspace = 1;
+    space_requested = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+process_set_priority(struct process *p, unsigned char prio)
+{
+  /* A pending poll stays on the list of the old priority. */
+  p->prio = prio;
+}
+/*---------------------------------------------------------------------------*/
+#if PROCESS_PROFILE
+void
+process_profile_print(void)
+{
+  struct process *p;
+
+  for(p = process_list; p != NULL; p = p->next) {
+    printf("profile '%s': %u calls, %lu ticks, max %u\n",
+	   p->name, p->prof_calls, p->prof_ticks, p->prof_max);
+  }
+}
+#endif /* PROCESS_PROFILE */
+/*---------------------------------------------------------------------------*/
+#if PROCESS_CONF_STATS
+unsigned short
+process_poll_count(struct process *p)
+{
+  return p->npolls;
+}
+#endif /* PROCESS_CONF_STATS */
+/*---------------------------------------------------------------------------*/
 int
 process_is_running(struct process *p)
 {
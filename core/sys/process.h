@@ -89,6 +89,53 @@ typedef unsigned char process_num_events_t;
 #define PROCESS_CONF_NUMEVENTS 32
 #endif /* PROCESS_CONF_NUMEVENTS */
 
+/**
+ * If not zero, call_process() measures the time spent in each process
+ * with RTIMER_NOW(): number of calls, total ticks and longest call.
+ * Time spent in a process called by another one (e.g., with
+ * process_post_synch()) is charged to the callee only; time spent in
+ * interrupt handlers is charged to the interrupted process.
+ */
+#ifdef PROCESS_CONF_PROFILE
+#define PROCESS_PROFILE PROCESS_CONF_PROFILE
+#else
+#define PROCESS_PROFILE 0
+#endif /* PROCESS_CONF_PROFILE */
+
+/**
+ * If not zero, an event posted to a process that still has the same
+ * event with the same data waiting to be delivered is dropped, and
+ * process_post() reports success.
+ */
+#ifdef PROCESS_CONF_COALESCE
+#define PROCESS_COALESCE PROCESS_CONF_COALESCE
+#else
+#define PROCESS_COALESCE 0
+#endif /* PROCESS_CONF_COALESCE */
+
+/**
+ * Maximum number of consecutive high-priority events handled while
+ * normal-priority polls or events are waiting. After that, one round
+ * of normal-priority work is done before the next high-priority event.
+ */
+#ifdef PROCESS_CONF_STARVATION_LIMIT
+#define PROCESS_STARVATION_LIMIT PROCESS_CONF_STARVATION_LIMIT
+#else
+#define PROCESS_STARVATION_LIMIT 8
+#endif /* PROCESS_CONF_STARVATION_LIMIT */
+
+/**
+ * \name Process priorities
+ *
+ * Polls and events of high-priority processes are handled before
+ * those of normal-priority processes.
+ * @{
+ */
+#define PROCESS_PRIO_NORMAL 0
+#define PROCESS_PRIO_HIGH   1
+#define PROCESS_PRIO_LEVELS 2
+/** @} */
+
 #define PROCESS_EVENT_NONE            0x80
 #define PROCESS_EVENT_INIT            0x81
 #define PROCESS_EVENT_POLL            0x82
@@ -310,7 +357,16 @@ struct process {
   const char *name;
   PT_THREAD((* thread)(struct pt *, process_event_t, process_data_t));
   struct pt pt;
-  unsigned char state, needspoll;
+  unsigned char state, needspoll, prio, waitspace;
+  struct process *nextpoll;
+#if PROCESS_CONF_STATS
+  unsigned short npolls;
+#endif /* PROCESS_CONF_STATS */
+#if PROCESS_PROFILE
+  unsigned short prof_calls;     /**< Number of calls */
+  unsigned short prof_max;       /**< Longest call, in rtimer ticks */
+  unsigned long prof_ticks;      /**< Total time, in rtimer ticks */
+#endif /* PROCESS_PROFILE */
 };
 
 /**
@@ -451,12 +507,69 @@ CCIF process_event_t process_alloc_event(void);
  * Request a process to be polled.
  *
  * This function typically is called from an interrupt handler to
- * cause a process to be polled.
+ * cause a process to be polled. The process is put on a list of
+ * processes to be polled, so the time until it runs does not depend
+ * on the number of processes in the system.
  *
  * \param p A pointer to the process' process structure.
  */
 CCIF void process_poll(struct process *p);
 
+/**
+ * Request a poll of a process when the event queue has room.
+ *
+ * A process that got PROCESS_ERR_FULL from process_post() calls
+ * this function and retries when it is polled, instead of polling
+ * itself until an event is delivered. If the queue has room already,
+ * the process is polled right away.
+ *
+ * \param p A pointer to the process' process structure.
+ */
+void process_request_space(struct process *p);
+
+/**
+ * Set the priority of a process.
+ *
+ * Processes have normal priority unless this function is called,
+ * typically before the process is started. A poll that is already
+ * pending is handled at the old priority.
+ *
+ * \param p A pointer to the process' process structure.
+ * \param prio PROCESS_PRIO_NORMAL or PROCESS_PRIO_HIGH.
+ */
+void process_set_priority(struct process *p, unsigned char prio);
+
+#if PROCESS_PROFILE
+/**
+ * Print the profile of each running process (only with
+ * PROCESS_CONF_PROFILE): one line with the number of calls, the total
+ * time and the longest call, in rtimer ticks.
+ */
+void process_profile_print(void);
+#endif /* PROCESS_PROFILE */
+
+#if PROCESS_CONF_STATS
+/**
+ * \name Event queue statistics (only with PROCESS_CONF_STATS)
+ * @{
+ */
+/** Largest number of events waiting to be delivered. */
+extern process_num_events_t process_maxevents;
+/** Number of events not posted because the queue was full. */
+extern unsigned short process_fullevents;
+/** Number of events dropped as duplicates (see PROCESS_CONF_COALESCE). */
+extern unsigned short process_coalesced;
+/** @} */
+
+/**
+ * Number of times a process has been polled (only with
+ * PROCESS_CONF_STATS).
+ *
+ * \param p A pointer to the process' process structure.
+ */
+unsigned short process_poll_count(struct process *p);
+#endif /* PROCESS_CONF_STATS */
+
 /** @} */
 
 /**
@@ -477,7 +590,9 @@ void process_init(void);
  *
  * This function should be called repeatedly from the main() program
  * to actually run the Contiki system. It calls the necessary poll
- * handlers, and processes one event. The function returns the number
+ * handlers, and processes one event. Polls and events of
+ * high-priority processes are handled first (see
+ * PROCESS_CONF_STARVATION_LIMIT). The function returns the number
  * of events that are waiting in the event queue so that the caller
  * may choose to put the CPU to sleep when there are no pending
  * events.
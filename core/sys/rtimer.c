@@ -56,12 +56,81 @@
 #define PRINTF(...)
 #endif
 
-static struct rtimer *next_rtimer;
+/*
+ * Pending tasks, in a binary heap ordered by their 32-bit time. last is
+ * the time of the task being (or last) executed.
+ */
+static struct rtimer *queue[RTIMER_QUEUE_SIZE];
+static unsigned char queued;
+static rtimer_long_clock_t last;
+static unsigned char running;
+
+#define BEFORE(a, b) RTIMER_LONG_CLOCK_LT((a)->time_long, (b)->time_long)
+
+/*---------------------------------------------------------------------------*/
+static void
+place(struct rtimer *t, unsigned char i)
+{
+  queue[i] = t;
+  t->index = i;
+}
+/*---------------------------------------------------------------------------*/
+/* Move t up from the hole at i to its place. */
+static void
+sift_up(struct rtimer *t, unsigned char i)
+{
+  unsigned char parent;
+
+  while(i > 0) {
+    parent = (i - 1) / 2;
+    if(!BEFORE(t, queue[parent])) {
+      break;
+    }
+    place(queue[parent], i);
+    i = parent;
+  }
+  place(t, i);
+}
+/*---------------------------------------------------------------------------*/
+/* Move t down from the hole at i to its place. */
+static void
+sift_down(struct rtimer *t, unsigned char i)
+{
+  unsigned char child;
+
+  while((child = 2 * i + 1) < queued) {
+    if(child + 1 < queued &&
+       BEFORE(queue[child + 1], queue[child])) {
+      child++;
+    }
+    if(!BEFORE(queue[child], t)) {
+      break;
+    }
+    place(queue[child], i);
+    i = child;
+  }
+  place(t, i);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove(unsigned char i)
+{
+  struct rtimer *tail = queue[--queued];
 
+  if(i < queued) {
+    if(i > 0 && BEFORE(tail, queue[(i - 1) / 2])) {
+      sift_up(tail, i);
+    } else {
+      sift_down(tail, i);
+    }
+  }
+}
 /*---------------------------------------------------------------------------*/
 void
 rtimer_init(void)
 {
+  queued = 0;
+  running = 0;
   rtimer_arch_init();
 }
 /*---------------------------------------------------------------------------*/
@@ -70,39 +139,85 @@ rtimer_set(struct rtimer *rtimer, rtimer_clock_t time,
 	   rtimer_clock_t duration,
 	   rtimer_callback_t func, void *ptr)
 {
-  int first = 0;
-
-  PRINTF("rtimer_set time %d\n", time);
+  rtimer_long_clock_t ref;
+  rtimer_clock_t ahead;
 
-  if(next_rtimer == NULL) {
-    first = 1;
+  /* The time is at most 2^15 ticks after the task being executed, or
+     after now; a time up to 2^15 ticks before it has already passed,
+     and rtimer_set_long() rejects it. */
+  ref = running ? last : RTIMER_NOW_LONG();
+  ahead = time - (rtimer_clock_t)ref;
+  if(ahead > 0x8000) {
+    return rtimer_set_long(rtimer, ref - (rtimer_clock_t)-ahead,
+                           duration, func, ptr);
   }
+  return rtimer_set_long(rtimer, ref + ahead, duration, func, ptr);
+}
+/*---------------------------------------------------------------------------*/
+int
+rtimer_set_long(struct rtimer *rtimer, rtimer_long_clock_t time,
+                rtimer_clock_t duration,
+                rtimer_callback_t func, void *ptr)
+{
+  struct rtimer *head;
+  rtimer_long_clock_t head_time = 0;
+  int s, ret = RTIMER_OK;
 
-  rtimer->func = func;
-  rtimer->ptr = ptr;
-
-  rtimer->time = time;
-  next_rtimer = rtimer;
+  PRINTF("rtimer_set_long time %lu\n", time);
 
-  if(first == 1) {
-    rtimer_arch_schedule(time);
+  s = splhigh();
+  head = queued > 0 ? queue[0] : NULL;
+  if(head != NULL) {
+    head_time = head->time_long;
+  }
+  if(rtimer->index < queued && queue[rtimer->index] == rtimer) {
+    heap_remove(rtimer->index);
   }
-  return RTIMER_OK;
+  if(RTIMER_LONG_CLOCK_LT(time, RTIMER_NOW_LONG() + RTIMER_GUARD_TIME)) {
+    ret = RTIMER_ERR_TIME;
+  } else if(queued == RTIMER_QUEUE_SIZE) {
+    ret = RTIMER_ERR_FULL;
+  } else {
+    rtimer->func = func;
+    rtimer->ptr = ptr;
+    rtimer->time = (rtimer_clock_t)time;
+    rtimer->time_long = time;
+    sift_up(rtimer, queued++);
+  }
+  /* The hardware only needs to be reprogrammed when the head changes,
+     and never from within rtimer_run_next(), which does it on return. */
+  if(!running && queued > 0 &&
+     (queue[0] != head || queue[0]->time_long != head_time)) {
+    rtimer_arch_schedule(queue[0]->time);
+  }
+  splx(s);
+  return ret;
 }
 /*---------------------------------------------------------------------------*/
 void
 rtimer_run_next(void)
 {
   struct rtimer *t;
-  if(next_rtimer == NULL) {
-    return;
-  }
-  t = next_rtimer;
-  next_rtimer = NULL;
-  t->func(t, t->ptr);
-  if(next_rtimer != NULL) {
-    rtimer_arch_schedule(next_rtimer->time);
+  rtimer_long_clock_t now;
+
+  while(queued > 0) {
+    t = queue[0];
+    now = RTIMER_NOW_LONG();
+    if(RTIMER_LONG_CLOCK_LT(now, t->time_long)) {
+      if(t->time_long - now >= RTIMER_GUARD_TIME) {
+        /* Matches the low 16 bits of the time: tasks more than 2^16
+           ticks ahead see early interrupts, which only reprogram it. */
+        rtimer_arch_schedule(t->time);
+        return;
+      }
+      /* Too close to be sure of the timer interrupt. */
+      while(RTIMER_LONG_CLOCK_LT(RTIMER_NOW_LONG(), t->time_long));
+    }
+    heap_remove(0);
+    last = t->time_long;
+    running = 1;
+    t->func(t, t->ptr);
+    running = 0;
   }
-  return;
 }
 /*---------------------------------------------------------------------------*/
@@ -60,6 +60,32 @@ typedef unsigned short rtimer_clock_t;
 #define RTIMER_CLOCK_LT(a,b)     ((signed short)((a)-(b)) < 0)
 #endif /* RTIMER_CLOCK_LT */
 
+/**
+ * \brief      Extended real-time clock: rtimer_clock_t with the count of
+ *             its overflows in the upper bits.
+ */
+typedef unsigned long rtimer_long_clock_t;
+#define RTIMER_LONG_CLOCK_LT(a,b) ((signed long)((a)-(b)) < 0)
+
+/**
+ * \brief      Maximum number of pending real-time tasks.
+ */
+#ifdef RTIMER_CONF_QUEUE_SIZE
+#define RTIMER_QUEUE_SIZE RTIMER_CONF_QUEUE_SIZE
+#else /* RTIMER_CONF_QUEUE_SIZE */
+#define RTIMER_QUEUE_SIZE 4
+#endif /* RTIMER_CONF_QUEUE_SIZE */
+
+/**
+ * \brief      Minimum distance between now and the time of a new task,
+ *             below which the hardware timer could miss it.
+ */
+#ifdef RTIMER_CONF_GUARD_TIME
+#define RTIMER_GUARD_TIME RTIMER_CONF_GUARD_TIME
+#else /* RTIMER_CONF_GUARD_TIME */
+#define RTIMER_GUARD_TIME 2
+#endif /* RTIMER_CONF_GUARD_TIME */
+
 /**
  * \brief      Initialize the real-time scheduler.
  *
@@ -83,6 +109,8 @@ struct rtimer {
   rtimer_clock_t time;
   rtimer_callback_t func;
   void *ptr;
+  rtimer_long_clock_t time_long;
+  unsigned char index;       /**< Position in the queue, if pending */
 };
 
 enum {
@@ -99,16 +127,37 @@ enum {
  * \param duration Unused argument.
  * \param func A function to be called when the task is executed.
  * \param ptr An opaque pointer that will be supplied as an argument to the callback function.
- * \return     Non-zero (true) if the task could be scheduled, zero
- *             (false) if the task could not be scheduled.
+ * \return     RTIMER_OK if the task was scheduled, RTIMER_ERR_FULL if
+ *             RTIMER_QUEUE_SIZE tasks are already pending, RTIMER_ERR_TIME
+ *             if the time has passed or is less than RTIMER_GUARD_TIME
+ *             away.
  *
  *             This function schedules a real-time task at a specified
- *             time in the future.
+ *             time in the future. Up to RTIMER_QUEUE_SIZE tasks can be
+ *             pending at once; setting a task that is already pending
+ *             moves it to the new time; on error it is no longer pending.
+ *
+ *             The time is taken to be at most 2^15 ticks after the
+ *             time of the task being executed, or after now when called
+ *             outside of a task; a time up to 2^15 ticks before it is
+ *             late and RTIMER_ERR_TIME is returned. Tasks whose time
+ *             passes while another task runs are executed late, in order.
  *
  */
 int rtimer_set(struct rtimer *task, rtimer_clock_t time,
 	       rtimer_clock_t duration, rtimer_callback_t func, void *ptr);
 
+/**
+ * \brief      Post a real-time task at an extended time.
+ * \param time The time when the task is to be executed, on the
+ *             RTIMER_NOW_LONG() clock.
+ *
+ *             Same as rtimer_set(), without the 2^16 ticks limit: the
+ *             time can be up to 2^31 ticks ahead.
+ */
+int rtimer_set_long(struct rtimer *task, rtimer_long_clock_t time,
+                    rtimer_clock_t duration, rtimer_callback_t func, void *ptr);
+
 /**
  * \brief      Execute the next real-time task and schedule the next task, if any
  *
@@ -129,6 +178,7 @@ void rtimer_run_next(void);
  * \hideinitializer
  */
 #define RTIMER_NOW() rtimer_arch_now()
+#define RTIMER_NOW_LONG() rtimer_arch_now_long()
 #define RTIMER_NOW_DCO() rtimer_arch_now_dco()
 
 /**
@@ -143,9 +193,11 @@ void rtimer_run_next(void);
  * \hideinitializer
  */
 #define RTIMER_TIME(task) ((task)->time)
+#define RTIMER_TIME_LONG(task) ((task)->time_long)
 
 void rtimer_arch_init(void);
 void rtimer_arch_schedule(rtimer_clock_t t);
+rtimer_long_clock_t rtimer_arch_now_long(void);
 /*rtimer_clock_t rtimer_arch_now(void);*/
 
 #define RTIMER_SECOND RTIMER_ARCH_SECOND
@@ -46,27 +46,145 @@
 
 #define MAX_TICKS (~((clock_time_t)0) / 2)
 
+/*
+ * In tickless mode the compare register CCR1 is programmed to the next
+ * etimer expiration rather than to every clock tick, and the clock is
+ * derived from the extended rtimer clock (TAR and its overflow count).
+ * The CPU wakes up at least once per second so that energest can flush
+ * its 16-bit counters before they wrap.
+ */
+#ifdef CLOCK_CONF_TICKLESS
+#define TICKLESS CLOCK_CONF_TICKLESS
+#else
+#define TICKLESS 0
+#endif
+
+#if TICKLESS
+/* Longest sleep between two compare interrupts, in clock ticks. */
+#define MAX_SLEEP CLOCK_SECOND
+
+#if (RTIMER_ARCH_SECOND % CLOCK_SECOND) != 0 || MAX_SLEEP * INTERVAL > 0x8000U
+#error CLOCK_CONF_TICKLESS needs CLOCK_CONF_SECOND to divide RTIMER_ARCH_SECOND.
+#endif
+#else /* TICKLESS */
 static volatile unsigned long seconds;
 
 static volatile clock_time_t count = 0;
 /* last_tar is used for calculating clock_fine, last_ccr might be better? */
 static unsigned short last_tar = 0;
+#endif /* TICKLESS */
+
+/* Make sure the CLOCK_CONF_SECOND is a power of two, to ensure
+   that the modulo operation below becomes a logical and and not
+   an expensive divide. Algorithm from Wikipedia:
+   http://en.wikipedia.org/wiki/Power_of_two */
+#if (CLOCK_CONF_SECOND & (CLOCK_CONF_SECOND - 1)) != 0
+#error CLOCK_CONF_SECOND must be a power of two (i.e., 1, 2, 4, 8, 16, 32, 64, ...).
+#error Change CLOCK_CONF_SECOND in contiki-conf.h.
+#endif
+#if TICKLESS
+/*---------------------------------------------------------------------------*/
+/**
+ * Program CCR1 to the next etimer expiration (or to MAX_SLEEP ticks
+ * from now, whichever comes first).
+ *
+ * \return Non-zero if an etimer is already due.
+ */
+static int
+schedule_next(void)
+{
+  unsigned long hi;
+  unsigned short lo;
+  clock_time_t now, dist;
+  int due, s;
+
+  s = splhigh();
+  do {
+    hi = rtimer_arch_overflows(&lo);
+    now = hi * (0x10000UL / INTERVAL) + lo / INTERVAL;
+    dist = MAX_SLEEP;
+    due = 0;
+    if(etimer_pending()) {
+      clock_time_t d = etimer_next_expiration_time() - now;
+      if(d - 1 > MAX_TICKS) {
+        /* Expires now or expired already. */
+        due = 1;
+      } else if(d < dist) {
+        dist = d;
+      }
+    }
+    TACCR1 = lo - lo % INTERVAL + dist * INTERVAL;
+    /* Retry if TAR reached the compare value while it was written. */
+  } while((unsigned short)(TACCR1 - TAR - 1) >= dist * INTERVAL);
+  splx(s);
+  return due;
+}
+#endif /* TICKLESS */
 /*---------------------------------------------------------------------------*/
 interrupt(TIMERA1_VECTOR) timera1 (void) {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
 
-  if(TAIV == 2) {
+  switch(TAIV) {
+  case 2:
+#if TICKLESS
+	  /* HW timer bug fix: Interrupt handler called before TR==CCR. */
+	  while(TACTL & MC1 && TACCR1 - TAR == 1);
+	  energest_flush();
+	  if(schedule_next()) {
+	    etimer_request_poll();
+	    LPM4_EXIT;
+	  }
+#else /* TICKLESS */
 	  etimer_interrupt();
 	  if(etimer_pending() &&
 	     (etimer_next_expiration_time() - count - 1) > MAX_TICKS) {
 	    etimer_request_poll();
 	    LPM4_EXIT;
 	  }
-   }
+#endif /* TICKLESS */
+	  break;
+  case 10:
+	  rtimer_arch_overflow();
+	  break;
+  }
 
   ENERGEST_OFF(ENERGEST_TYPE_IRQ);
 }
+#if TICKLESS
+/*---------------------------------------------------------------------------*/
+/**
+ * Reprogram CCR1 after a change of the etimer list. Called by etimer
+ * whenever the next expiration time changes.
+ */
+void etimer_interrupt(void) {
+  if(schedule_next()) {
+    etimer_request_poll();
+  }
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  unsigned long hi;
+  unsigned short lo;
 
+  hi = rtimer_arch_overflows(&lo);
+  return hi * (0x10000UL / INTERVAL) + lo / INTERVAL;
+}
+/*---------------------------------------------------------------------------*/
+int
+clock_fine_max(void)
+{
+  return INTERVAL;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+clock_fine(void)
+{
+  return TAR % INTERVAL;
+}
+#else /* TICKLESS */
+/*---------------------------------------------------------------------------*/
 void etimer_interrupt(void) {
 /* HW timer bug fix: Interrupt handler called before TR==CCR.
  * Occurrs when timer state is toggled between STOP and CONT. */
@@ -79,14 +197,6 @@ do {
   /*      TACTL |= MC1;*/
   ++count;
 
-  /* Make sure the CLOCK_CONF_SECOND is a power of two, to ensure
- that the modulo operation below becomes a logical and and not
- an expensive divide. Algorithm from Wikipedia:
- http://en.wikipedia.org/wiki/Power_of_two */
-#if (CLOCK_CONF_SECOND & (CLOCK_CONF_SECOND - 1)) != 0
-#error CLOCK_CONF_SECOND must be a power of two (i.e., 1, 2, 4, 8, 16, 32, 64, ...).
-#error Change CLOCK_CONF_SECOND in contiki-conf.h.
-#endif
   if(count % CLOCK_CONF_SECOND == 0) {
 ++seconds;
 	energest_flush();
@@ -131,6 +241,7 @@ clock_fine(void)
   /* perform calc based on t, TAR will not be changed during interrupt */
   return (unsigned short) (TAR - t);
 }
+#endif /* TICKLESS */
 /*---------------------------------------------------------------------------*/
 void
 clock_init(void)
@@ -153,7 +264,9 @@ clock_init(void)
   /* Start Timer_A in continuous mode. */
   TACTL |= MC1;
 
+#if !TICKLESS
   count = 0;
+#endif /* TICKLESS */
 
   /* Enable interrupts. */
   eint();
@@ -166,8 +279,12 @@ clock_init(void)
 void
 clock_delay(unsigned int i)
 {
+#ifdef __MSP430__
   asm("add #-1, r15");
   asm("jnz $-2");
+#else /* __MSP430__ */
+  __delay_cycles(3 * i);
+#endif /* __MSP430__ */
   /*
    * This means that delay(i) will delay the CPU for CONST + 3x
    * cycles. On a 2.4756 CPU, this means that each i adds 1.22us of
@@ -201,12 +318,20 @@ clock_set_seconds(unsigned long sec)
 unsigned long
 clock_seconds(void)
 {
+#if TICKLESS
+  unsigned long hi;
+  unsigned short lo;
+
+  hi = rtimer_arch_overflows(&lo);
+  return hi * (0x10000UL / RTIMER_ARCH_SECOND) + lo / RTIMER_ARCH_SECOND;
+#else /* TICKLESS */
   unsigned long t1, t2;
   do {
     t1 = seconds;
     t2 = seconds;
   } while(t1 != t2);
   return t1;
+#endif /* TICKLESS */
 }
 /*---------------------------------------------------------------------------*/
 rtimer_clock_t
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <legacymsp430.h>
 
+#include "sys/deferred.h"
 #include "sys/energest.h"
 #include "dev/uart1.h"
 #include "dev/watchdog.h"
@@ -53,13 +54,117 @@ static volatile uint8_t transmitting;
 #define TX_WITH_INTERRUPT 1
 #endif /* UART1_CONF_TX_WITH_INTERRUPT */
 
-#if TX_WITH_INTERRUPT
+#ifdef UART1_CONF_TX_NONBLOCKING
+#define TX_NONBLOCKING UART1_CONF_TX_NONBLOCKING
+#else /* UART1_CONF_TX_NONBLOCKING */
+#define TX_NONBLOCKING 0
+#endif /* UART1_CONF_TX_NONBLOCKING */
+
+#ifdef UART1_CONF_TX_BUFSIZE
+#define TXBUFSIZE UART1_CONF_TX_BUFSIZE
+#else /* UART1_CONF_TX_BUFSIZE */
 #define TXBUFSIZE 64
+#endif /* UART1_CONF_TX_BUFSIZE */
+
+#ifdef UART1_CONF_TX_WITH_DMA
+#define TX_WITH_DMA UART1_CONF_TX_WITH_DMA
+#else /* UART1_CONF_TX_WITH_DMA */
+#define TX_WITH_DMA 0
+#endif /* UART1_CONF_TX_WITH_DMA */
+
+/*
+ * Deferred input: the receive interrupt only reads the byte and queues
+ * the input handler as a deferred call (see sys/deferred.h), which the
+ * main loop runs. Bytes are dropped, and counted by
+ * deferred_overflows(), if the main loop falls behind by more than
+ * DEFERRED_CONF_SIZE calls.
+ */
+#ifdef UART1_CONF_DEFER_INPUT
+#define DEFER_INPUT UART1_CONF_DEFER_INPUT
+#else /* UART1_CONF_DEFER_INPUT */
+#define DEFER_INPUT 0
+#endif /* UART1_CONF_DEFER_INPUT */
+
+#if TX_WITH_DMA && !TX_NONBLOCKING
+#error UART1_CONF_TX_WITH_DMA requires UART1_CONF_TX_NONBLOCKING
+#endif
 
+#if TX_NONBLOCKING
+#if !TX_WITH_INTERRUPT
+#error UART1_CONF_TX_NONBLOCKING requires UART1_CONF_TX_WITH_INTERRUPT
+#endif
+#if TXBUFSIZE & (TXBUFSIZE - 1)
+#error UART1_CONF_TX_BUFSIZE must be a power of two
+#endif
+
+/*
+ * Non-blocking transmission: uart1_writeb() never waits. Bytes are
+ * staged after tx_put and handed to the interrupt handler (by moving
+ * tx_put to line_put) only at the end of a line or of a SLIP frame, so
+ * that when the buffer fills up whole lines are dropped, never parts
+ * of them. A SLIP frame may contain '\n' bytes (SLIP does not escape
+ * them), so it is committed only at the END that closes it: an END
+ * closes a non-empty frame, otherwise it opens one.
+ */
+#define SLIP_END 0300
+
+static uint8_t txbuf_data[TXBUFSIZE];
+static volatile uint16_t tx_get, tx_put;
+static uint16_t line_put;
+static uint8_t line_dropped;
+static uint8_t slip_open, slip_empty;
+static unsigned long tx_dropped;
+
+#if TX_WITH_DMA
+/*
+ * DMA transmission: instead of the TX interrupt, DMA channel 0,
+ * triggered by UTXIFG1, copies each contiguous run of committed bytes
+ * to TXBUF1 and interrupts once at its end. dma_len is the length of
+ * the run in flight.
+ */
+static uint16_t dma_len;
+#endif /* TX_WITH_DMA */
+#elif TX_WITH_INTERRUPT
 static struct ringbuf txbuf;
 static uint8_t txbuf_data[TXBUFSIZE];
-#endif /* TX_WITH_INTERRUPT */
+#endif /* TX_NONBLOCKING */
 
+/*---------------------------------------------------------------------------*/
+#if TX_WITH_DMA
+/*
+ * Hand the next contiguous run of committed bytes to the DMA channel.
+ * The channel only reacts to a rising edge of UTXIFG1: when TXBUF1 is
+ * already empty no edge is coming, so the first byte is written by hand.
+ */
+static void
+dma_start(void)
+{
+  uint16_t get, len;
+
+  while(tx_get != tx_put) {
+    get = tx_get & (TXBUFSIZE - 1);
+    len = tx_put - tx_get;
+    if(len > TXBUFSIZE - get) {
+      len = TXBUFSIZE - get;
+    }
+    if(!(IFG2 & UTXIFG1)) {
+      DMA0SA = (uintptr_t)&txbuf_data[get];
+      DMA0SZ = len;
+      DMA0CTL |= DMAEN;
+      if(!(IFG2 & UTXIFG1)) {
+        dma_len = len;
+        transmitting = 1;
+        return;
+      }
+      /* UTXIFG1 rose before the channel was armed. */
+      DMA0CTL &= ~DMAEN;
+    }
+    TXBUF1 = txbuf_data[get];
+    tx_get++;
+  }
+  transmitting = 0;
+}
+#endif /* TX_WITH_DMA */
 /*---------------------------------------------------------------------------*/
 uint8_t
 uart1_active(void)
@@ -73,11 +178,63 @@ uart1_set_input(int (*input)(unsigned char c))
   uart1_input_handler = input;
 }
 /*---------------------------------------------------------------------------*/
+unsigned long
+uart1_tx_dropped(void)
+{
+#if TX_NONBLOCKING
+  return tx_dropped;
+#else /* TX_NONBLOCKING */
+  return 0;
+#endif /* TX_NONBLOCKING */
+}
+/*---------------------------------------------------------------------------*/
 void
 uart1_writeb(unsigned char c)
 {
+#if TX_NONBLOCKING
+  uint8_t commit;
+#endif /* TX_NONBLOCKING */
+
   watchdog_periodic();
-#if TX_WITH_INTERRUPT
+#if TX_NONBLOCKING
+
+  if(line_dropped) {
+    tx_dropped++;
+  } else if((uint16_t)(line_put - tx_get) < TXBUFSIZE) {
+    txbuf_data[line_put++ & (TXBUFSIZE - 1)] = c;
+  } else {
+    /* Buffer full: drop the bytes staged for this line and the rest
+       of it. */
+    tx_dropped += (uint16_t)(line_put - tx_put) + 1;
+    line_put = tx_put;
+    line_dropped = 1;
+  }
+
+  if(c == SLIP_END) {
+    commit = slip_open && !slip_empty;
+    slip_open = !commit;
+    slip_empty = 1;
+  } else {
+    commit = c == '\n' && !slip_open;
+    slip_empty = 0;
+  }
+
+  if(commit) {
+    line_dropped = 0;
+    tx_put = line_put;
+    /* If there is no transmission going, we need to start it by putting
+       the first byte into the UART. */
+    if(transmitting == 0 && tx_get != tx_put) {
+#if TX_WITH_DMA
+      dma_start();
+#else /* TX_WITH_DMA */
+      transmitting = 1;
+      TXBUF1 = txbuf_data[tx_get++ & (TXBUFSIZE - 1)];
+#endif /* TX_WITH_DMA */
+    }
+  }
+
+#elif TX_WITH_INTERRUPT
 
   /* Put the outgoing byte on the transmission buffer. If the buffer
      is full, we just keep on trying to put the byte into the buffer
@@ -204,11 +361,31 @@ uart1_init(unsigned long ubr)
   transmitting = 0;
 
   IE2 |= URXIE1;                        /* Enable USART1 RX interrupt  */
-#if TX_WITH_INTERRUPT
+#if TX_NONBLOCKING
+  tx_get = tx_put = line_put = 0;
+  line_dropped = 0;
+#if TX_WITH_DMA
+  /* Channel 0: single byte transfers from the ring to TXBUF1 on UTXIFG1. */
+  DMACTL0 = (DMACTL0 & ~DMA0TSEL_15) | DMA0TSEL_10;
+  DMA0DA = (uintptr_t)&TXBUF1;
+  DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASBDB | DMAIE;
+#else /* TX_WITH_DMA */
+  IE2 |= UTXIE1;                        /* Enable USART1 TX interrupt  */
+#endif /* TX_WITH_DMA */
+#elif TX_WITH_INTERRUPT
   ringbuf_init(&txbuf, txbuf_data, sizeof(txbuf_data));
   IE2 |= UTXIE1;                        /* Enable USART1 TX interrupt  */
-#endif /* TX_WITH_INTERRUPT */
+#endif /* TX_NONBLOCKING */
+}
+/*---------------------------------------------------------------------------*/
+#if DEFER_INPUT
+static void
+input_deferred(void *c)
+{
+  /* Running in the main loop: no need to wake the CPU up. */
+  uart1_input_handler((unsigned char)(uintptr_t)c);
 }
+#endif /* DEFER_INPUT */
 /*---------------------------------------------------------------------------*/
 interrupt(UART1RX_VECTOR)
 uart1_rx_interrupt(void)
@@ -230,28 +407,56 @@ uart1_rx_interrupt(void)
     } else {
       c = RXBUF1;
       if(uart1_input_handler != NULL) {
+#if DEFER_INPUT
+	if(deferred_call(input_deferred, (void *)(uintptr_t)c)) {
+	  LPM4_EXIT;
+	}
+#else /* DEFER_INPUT */
 	if(uart1_input_handler(c)) {
 	  LPM4_EXIT;
 	}
+#endif /* DEFER_INPUT */
       }
     }
   }
   ENERGEST_OFF(ENERGEST_TYPE_IRQ);
 }
 /*---------------------------------------------------------------------------*/
-#if TX_WITH_INTERRUPT
+#if TX_WITH_DMA
+interrupt(DACDMA_VECTOR)
+dma_interrupt(void)
+{
+  ENERGEST_ON(ENERGEST_TYPE_IRQ);
+
+  if(DMA0CTL & DMAIFG) {
+    DMA0CTL &= ~DMAIFG;
+    tx_get += dma_len;
+    dma_start();
+  }
+
+  ENERGEST_OFF(ENERGEST_TYPE_IRQ);
+}
+#elif TX_WITH_INTERRUPT
 interrupt(UART1TX_VECTOR)
 uart1_tx_interrupt(void)
 {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
 
+#if TX_NONBLOCKING
+  if(tx_get == tx_put) {
+    transmitting = 0;
+  } else {
+    TXBUF1 = txbuf_data[tx_get++ & (TXBUFSIZE - 1)];
+  }
+#else /* TX_NONBLOCKING */
   if(ringbuf_elements(&txbuf) == 0) {
     transmitting = 0;
   } else {
     TXBUF1 = ringbuf_get(&txbuf);
   }
+#endif /* TX_NONBLOCKING */
 
   ENERGEST_OFF(ENERGEST_TYPE_IRQ);
 }
-#endif /* TX_WITH_INTERRUPT */
+#endif /* TX_WITH_DMA */
 /*---------------------------------------------------------------------------*/
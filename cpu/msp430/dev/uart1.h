@@ -50,4 +50,10 @@ void uart1_writeb(unsigned char c);
 void uart1_init(unsigned long ubr);
 uint8_t uart1_active(void);
 
+/**
+ * Number of bytes dropped because the transmit buffer was full
+ * (only with UART1_CONF_TX_NONBLOCKING, zero otherwise).
+ */
+unsigned long uart1_tx_dropped(void);
+
 #endif /* __UART1_H__ */
@@ -181,6 +181,85 @@ init_ports(void)
 extern int _end;		/* Not in sys/unistd.h */
 static char *cur_break = (char *)&_end;
 
+#define asmv(arg) __asm__ __volatile__(arg)
+
+#if MSP430_STACK_PAINT
+extern int __stack;		/* Top of RAM, from the linker script */
+
+#define STACK_PAINT 0xa5a5
+
+/*
+ * Fill the RAM between the heap and the stack pointer with STACK_PAINT.
+ * Called with interrupts disabled, so nothing lives below the stack
+ * pointer.
+ */
+static void
+paint_stack(void)
+{
+  uint16_t *p, *stack_pointer;
+
+  asmv("mov r1, %0" : "=r" (stack_pointer));
+  for(p = (uint16_t *)cur_break; p < stack_pointer; p++) {
+    *p = STACK_PAINT;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * End of the heap. malloc() of msp430-libc does not call sbrk(): it
+ * takes the RAM from _end up itself, as a chain of blocks, each after
+ * a header word ((size in words << 1) | busy), closed by HEAP_LAST.
+ * Before the first malloc() the first word still holds STACK_PAINT.
+ */
+#define HEAP_LAST 0xfffe
+
+static uint16_t *
+heap_end(void)
+{
+  uint16_t *p;
+
+  p = (uint16_t *)cur_break;
+  if(*p == STACK_PAINT) {
+    return p;
+  }
+  while(*p != HEAP_LAST && p < (uint16_t *)&__stack) {
+    p += 1 + (*p >> 1);
+  }
+  return p + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Lowest word overwritten by the stack since boot. */
+static uint16_t *
+stack_low(void)
+{
+  uint16_t *p;
+
+  for(p = heap_end(); p < (uint16_t *)&__stack; p++) {
+    if(*p != STACK_PAINT) {
+      break;
+    }
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_stack_max(void)
+{
+  return (char *)&__stack - (char *)stack_low();
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_stack_margin(void)
+{
+  return (char *)stack_low() - (char *)heap_end();
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_heap_used(void)
+{
+  return (char *)heap_end() - (char *)&_end;
+}
+#endif /* MSP430_STACK_PAINT */
+/*---------------------------------------------------------------------------*/
 void
 msp430_cpu_init(void)
 {
@@ -188,13 +267,15 @@ msp430_cpu_init(void)
   watchdog_init();
   init_ports();
   msp430_init_dco();
-  eint();
   if((uintptr_t)cur_break & 1) { /* Workaround for msp430-ld bug! */
     cur_break++;
   }
+#if MSP430_STACK_PAINT
+  paint_stack();
+#endif /* MSP430_STACK_PAINT */
+  eint();
 }
 /*---------------------------------------------------------------------------*/
-#define asmv(arg) __asm__ __volatile__(arg)
 
 #define STACK_EXTRA 32
 
@@ -217,9 +298,11 @@ sbrk(int incr)
   void *old_break = cur_break;
   cur_break += incr;
   /*
-   * If the stack was never here then [old_break .. cur_break] should
-   * be filled with zeros.
-  */
+   * [old_break .. cur_break] is not zeroed: it holds whatever the
+   * stack left there, or STACK_PAINT (0xa5a5) with MSP430_STACK_PAINT.
+   * Callers must clear it themselves. Note that malloc() of msp430-libc
+   * does not come here (see heap_end()).
+   */
   return old_break;
 }
 /*---------------------------------------------------------------------------*/
@@ -64,6 +64,27 @@ void msp430_sync_dco(void);
 
 void   *sbrk(int);
 
+/*
+ * Stack painting: at boot, the free RAM between the heap and the stack
+ * is filled with a known pattern, so that the deepest point ever
+ * reached by the stack can be found later. The functions below return
+ * sizes in bytes.
+ */
+#ifdef MSP430_CONF_STACK_PAINT
+#define MSP430_STACK_PAINT MSP430_CONF_STACK_PAINT
+#else
+#define MSP430_STACK_PAINT 0
+#endif
+
+#if MSP430_STACK_PAINT
+/* Largest stack size so far (high-watermark). */
+unsigned short msp430_stack_max(void);
+/* Free RAM left between the heap and the high-watermark of the stack. */
+unsigned short msp430_stack_margin(void);
+/* RAM taken by the heap of malloc(). */
+unsigned short msp430_heap_used(void);
+#endif /* MSP430_STACK_PAINT */
+
 typedef int spl_t;
 void    splx_(spl_t);
 spl_t   splhigh_(void);
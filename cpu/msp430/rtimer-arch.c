@@ -52,6 +52,10 @@
 #define PRINTF(...)
 #endif
 
+/* Overflows of Timer A, counted by rtimer_arch_overflow(). The low 16
+   bits are the upper half of the extended clock. */
+static volatile unsigned long overflows;
+
 /*---------------------------------------------------------------------------*/
 interrupt(TIMERA0_VECTOR) timera0 (void) {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
@@ -72,6 +76,10 @@ rtimer_arch_init(void)
   /* CCR0 interrupt enabled, interrupt occurs when timer equals CCR0. */
   TACCTL0 = CCIE;
 
+  /* Overflow interrupt enabled, for the extended clock. */
+  overflows = 0;
+  TACTL |= TAIE;
+
   /* Enable interrupts. */
   eint();
 }
@@ -86,3 +94,47 @@ rtimer_arch_schedule(rtimer_clock_t t)
   TACTL |= MC1;
 }
 /*---------------------------------------------------------------------------*/
+/**
+ * Count an overflow of Timer A, called by the Timer A1 interrupt
+ * handler on TAIV_OVERFLOW.
+ */
+void
+rtimer_arch_overflow(void)
+{
+  overflows++;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Read the number of overflows of Timer A and, consistently with it,
+ * the current value of TAR.
+ */
+unsigned long
+rtimer_arch_overflows(unsigned short *tar)
+{
+  unsigned long hi;
+  unsigned short lo;
+  int s;
+
+  s = splhigh();
+  hi = overflows;
+  lo = TAR;
+  if(TACTL & TAIFG) {
+    /* The timer wrapped and the interrupt has not been served yet. */
+    lo = TAR;
+    hi++;
+  }
+  splx(s);
+  *tar = lo;
+  return hi;
+}
+/*---------------------------------------------------------------------------*/
+rtimer_long_clock_t
+rtimer_arch_now_long(void)
+{
+  unsigned long hi;
+  unsigned short lo;
+
+  hi = rtimer_arch_overflows(&lo);
+  return (hi << 16) | lo;
+}
+/*---------------------------------------------------------------------------*/
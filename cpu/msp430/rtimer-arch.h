@@ -49,4 +49,7 @@
 #define rtimer_arch_now() (TAR)
 #define rtimer_arch_now_dco() (TBR)
 
+void rtimer_arch_overflow(void);
+unsigned long rtimer_arch_overflows(unsigned short *tar);
+
 #endif /* __RTIMER_ARCH_H__ */
@@ -0,0 +1,183 @@
+/* -*- C -*- */
+/*
+ * Configuration of the sky-sim target: the Tmote Sky firmware built for
+ * the host and executed by the discrete-event simulator in sim.c.
+ *
+ * Everything that is not dictated by the simulated hardware mirrors
+ * platform/sky/contiki-conf.h, so that applications behave the same on
+ * both targets.
+ */
+
+#ifndef CONTIKI_CONF_H
+#define CONTIKI_CONF_H
+
+#define COOJA 0
+#define TINYOS_SERIAL_FRAMES 0
+
+#ifndef RF_CHANNEL
+#define RF_CHANNEL              26
+#endif /* RF_CHANNEL */
+
+#define ENERGEST_CONF_ON 1
+
+#define HAVE_STDINT_H
+/* Paint the free RAM at boot to track the stack high-watermark. */
+#define MSP430_CONF_STACK_PAINT 1
+#include "msp430def.h"
+
+/* msp430def.h defines splx() with inline assembly. */
+#undef splx
+#define splx(sr) splx_(sr)
+
+#define CCIF
+#define CLIF
+
+#define PROCESS_CONF_NUMEVENTS 8
+#define PROCESS_CONF_STATS 1
+#define PROCESS_CONF_COALESCE 1
+#define PROCESS_CONF_PROFILE 1
+
+/* CPU target speed in Hz */
+#define F_CPU 4194304uL
+
+/* Our clock resolution, this is the same as Unix HZ. */
+#define CLOCK_CONF_SECOND 128UL
+
+/* Wake up for the next etimer rather than at every clock tick. */
+#define CLOCK_CONF_TICKLESS 1
+
+/* Sleep in LPM0 rather than busy-wait during Glossy phases. */
+#define GLOSSY_CONF_LPM 1
+
+/* Read received packets in chunks of 4 bytes on FIFOP interrupts. */
+#define GLOSSY_CONF_RX_CHUNK 4
+
+/* Copy received packets to the TXFIFO by DMA when relaying them. */
+#define GLOSSY_CONF_TX_DMA 1
+
+/* Measure the constant part of the Glossy SFD interrupt delay at startup. */
+#define GLOSSY_CONF_CALIBRATE_IRQ 1
+
+#define BAUD2UBR(baud) ((F_CPU/baud))
+
+/* Simulated time only advances on register accesses, so the firmware
+   must not busy-wait on memory for room in the interrupt-driven
+   transmit buffer: use the non-blocking mode, as on the sky. */
+#define UART1_CONF_TX_WITH_INTERRUPT 1
+#define UART1_CONF_TX_NONBLOCKING 1
+#define UART1_CONF_TX_BUFSIZE 512
+#define UART1_CONF_TX_WITH_DMA 1
+
+/* Serial input is handed to the main loop (see sys/deferred.h): the
+   receive interrupt only reads the byte, so that it never delays the
+   SFD capture of Glossy. */
+#define UART1_CONF_DEFER_INPUT 1
+
+/* LED ports */
+#define LEDS_PxDIR P5DIR
+#define LEDS_PxOUT P5OUT
+#define LEDS_CONF_RED    0x10
+#define LEDS_CONF_GREEN  0x20
+#define LEDS_CONF_YELLOW 0x40
+
+typedef unsigned long clock_time_t;
+
+#define ROM_ERASE_UNIT_SIZE  512
+#define XMEM_ERASE_UNIT_SIZE (64*1024L)
+
+/* Use the first 64k of external flash for node configuration */
+#define NODE_ID_XMEM_OFFSET     (0 * XMEM_ERASE_UNIT_SIZE)
+
+/*
+ * SPI bus (USART0) towards the simulated CC2420. A byte written to
+ * SPI_TXBUF is shifted out when the firmware waits for it, reads
+ * SPI_RXBUF or releases the chip select, or on time when written by DMA.
+ */
+void sim_spi_wait(void);
+uint8_t sim_spi_rxbuf(void);
+void sim_spi_select(int on);
+int sim_spi_selected(void);
+
+#define SPI_TXBUF U0TXBUF
+#define SPI_RXBUF sim_spi_rxbuf()
+
+#define	SPI_WAITFOREOTx() sim_spi_wait()
+#define	SPI_WAITFOREORx() sim_spi_wait()
+#define SPI_WAITFORTxREADY() sim_spi_wait()
+
+/* DMA channel 1 feeds SPI_TXBUF on UTXIFG0 (see FASTSPI_WRITE_FIFO_DMA);
+   channel 0 is left to the UART. */
+#define SPI_DMA_WRITE(p,c) do {\
+  DMACTL0 = (DMACTL0 & ~DMA1TSEL_15) | DMA1TSEL_4;\
+  DMA1SA = (uintptr_t)(p);\
+  DMA1DA = (uintptr_t)&SPI_TXBUF;\
+  DMA1SZ = (c);\
+  DMA1CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASBDB | DMAEN;\
+} while (0)
+#define SPI_DMA_BUSY() (DMA1CTL & DMAEN)
+
+#define SCK            1  /* P3.1 - Output: SPI Serial Clock (SCLK) */
+#define MOSI           2  /* P3.2 - Output: SPI Master out - slave in (MOSI) */
+#define MISO           3  /* P3.3 - Input:  SPI Master in - slave out (MISO) */
+
+#define FLASH_PWR	3	/* P4.3 Output */
+#define FLASH_CS	4	/* P4.4 Output */
+#define FLASH_HOLD	7	/* P4.7 Output */
+
+#define SPI_FLASH_ENABLE()  ( P4OUT &= ~BV(FLASH_CS) )
+#define SPI_FLASH_DISABLE() ( P4OUT |=  BV(FLASH_CS) )
+
+#define SPI_FLASH_HOLD()		( P4OUT &= ~BV(FLASH_HOLD) )
+#define SPI_FLASH_UNHOLD()		( P4OUT |=  BV(FLASH_HOLD) )
+
+/*
+ * CC2420 pin configuration.
+ */
+
+#define FIFO_P         0  /* P1.0 - Input: FIFOP from CC2420 */
+#define FIFO           3  /* P1.3 - Input: FIFO from CC2420 */
+#define CCA            4  /* P1.4 - Input: CCA from CC2420 */
+
+#define SFD            1  /* P4.1 - Input:  SFD from CC2420 */
+#define CSN            2  /* P4.2 - Output: SPI Chip Select (CS_N) */
+#define VREG_EN        5  /* P4.5 - Output: VREG_EN to CC2420 */
+#define RESET_N        6  /* P4.6 - Output: RESET_N to CC2420 */
+
+/* Pin status, sampled from the radio model at the current node time. */
+int sim_radio_pin(int pin);
+
+#define FIFO_IS_1       (sim_radio_pin(FIFO))
+#define CCA_IS_1        (sim_radio_pin(CCA))
+#define RESET_IS_1      (!!(P4IN & BV(RESET_N)))
+#define VREG_IS_1       (!!(P4IN & BV(VREG_EN)))
+#define FIFOP_IS_1      (sim_radio_pin(FIFO_P))
+#define SFD_IS_1        (sim_radio_pin(SFD))
+
+/* The CC2420 reset pin. */
+#define SET_RESET_INACTIVE()    ( P4OUT |=  BV(RESET_N) )
+#define SET_RESET_ACTIVE()      ( P4OUT &= ~BV(RESET_N) )
+
+/* CC2420 voltage regulator enable pin. */
+#define SET_VREG_ACTIVE()       ( P4OUT |=  BV(VREG_EN) )
+#define SET_VREG_INACTIVE()     ( P4OUT &= ~BV(VREG_EN) )
+
+/* CC2420 rising edge trigger for external interrupt 0 (FIFOP). */
+#define FIFOP_INT_INIT() do {\
+  P1IES &= ~BV(FIFO_P);\
+  CLEAR_FIFOP_INT();\
+} while (0)
+
+/* FIFOP on external interrupt 0. */
+#define ENABLE_FIFOP_INT()          do { P1IE |= BV(FIFO_P); } while (0)
+#define DISABLE_FIFOP_INT()         do { P1IE &= ~BV(FIFO_P); } while (0)
+#define CLEAR_FIFOP_INT()           do { P1IFG &= ~BV(FIFO_P); } while (0)
+
+#define SPI_ENABLE()    ( sim_spi_select(1) ) /* ENABLE CSn (active low) */
+#define SPI_DISABLE()   ( sim_spi_select(0) ) /* DISABLE CSn (active low) */
+#define SPI_IS_ENABLED()   ( sim_spi_selected() )
+
+#ifdef PROJECT_CONF_H
+#include PROJECT_CONF_H
+#endif /* PROJECT_CONF_H */
+
+#endif /* CONTIKI_CONF_H */
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Host replacement for the mspgcc <legacymsp430.h> header.
+ *
+ *         Every MSP430F1611 peripheral register used by the firmware is
+ *         an lvalue inside the register file of the node currently
+ *         being simulated. Each access goes through the simulator, which
+ *         charges the access to the node's DCO clock, serves the
+ *         interrupts that became due and applies the side effects of the
+ *         previous write (timer reprogramming, USART transmission, ...).
+ */
+
+#ifndef LEGACYMSP430_H_
+#define LEGACYMSP430_H_
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------*/
+/* 16-bit registers. The first SIM_R16_WATCHED ones have write side effects. */
+enum {
+  SIM_R16_TACTL,
+  SIM_R16_TAR,
+  SIM_R16_TACCTL0,
+  SIM_R16_TACCTL1,
+  SIM_R16_TACCTL2,
+  SIM_R16_TACCR0,
+  SIM_R16_TACCR1,
+  SIM_R16_TACCR2,
+  SIM_R16_TBCTL,
+  SIM_R16_TBR,
+  SIM_R16_TBCCTL0,
+  SIM_R16_TBCCTL1,
+  SIM_R16_TBCCTL2,
+  SIM_R16_TBCCTL3,
+  SIM_R16_TBCCTL4,
+  SIM_R16_TBCCTL5,
+  SIM_R16_TBCCTL6,
+  SIM_R16_TBCCR0,
+  SIM_R16_TBCCR1,
+  SIM_R16_TBCCR2,
+  SIM_R16_TBCCR3,
+  SIM_R16_TBCCR4,
+  SIM_R16_TBCCR5,
+  SIM_R16_TBCCR6,
+  SIM_R16_U0TXBUF,
+  SIM_R16_U1TXBUF,
+  SIM_R16_DMA0CTL,
+  SIM_R16_DMA1CTL,
+  SIM_R16_DMA2CTL,
+  SIM_R16_WATCHED,
+  SIM_R16_WDTCTL = SIM_R16_WATCHED,
+  SIM_R16_DMACTL0,
+  SIM_R16_DMACTL1,
+  SIM_R16_DMA0SZ,
+  SIM_R16_DMA1SZ,
+  SIM_R16_DMA2SZ,
+  SIM_R16_NUM
+};
+
+/* 8-bit registers. */
+enum {
+  SIM_R8_IE1,
+  SIM_R8_IE2,
+  SIM_R8_IFG1,
+  SIM_R8_IFG2,
+  SIM_R8_ME1,
+  SIM_R8_ME2,
+  SIM_R8_P1IN, SIM_R8_P1OUT, SIM_R8_P1DIR, SIM_R8_P1SEL,
+  SIM_R8_P1IE, SIM_R8_P1IES, SIM_R8_P1IFG,
+  SIM_R8_P2IN, SIM_R8_P2OUT, SIM_R8_P2DIR, SIM_R8_P2SEL,
+  SIM_R8_P2IE, SIM_R8_P2IES, SIM_R8_P2IFG,
+  SIM_R8_P3IN, SIM_R8_P3OUT, SIM_R8_P3DIR, SIM_R8_P3SEL,
+  SIM_R8_P4IN, SIM_R8_P4OUT, SIM_R8_P4DIR, SIM_R8_P4SEL,
+  SIM_R8_P5IN, SIM_R8_P5OUT, SIM_R8_P5DIR, SIM_R8_P5SEL,
+  SIM_R8_P6IN, SIM_R8_P6OUT, SIM_R8_P6DIR, SIM_R8_P6SEL,
+  SIM_R8_U0CTL, SIM_R8_U0TCTL, SIM_R8_U0RCTL, SIM_R8_U0MCTL,
+  SIM_R8_U0BR0, SIM_R8_U0BR1, SIM_R8_U0RXBUF,
+  SIM_R8_U1CTL, SIM_R8_U1TCTL, SIM_R8_U1RCTL, SIM_R8_U1MCTL,
+  SIM_R8_U1BR0, SIM_R8_U1BR1, SIM_R8_U1RXBUF,
+  SIM_R8_DCOCTL, SIM_R8_BCSCTL1, SIM_R8_BCSCTL2,
+  SIM_R8_CACTL1, SIM_R8_CACTL2,
+  SIM_R8_NUM
+};
+
+uint16_t *sim_reg16(int r);
+uint8_t *sim_reg8(int r);
+uint16_t sim_taiv(void);
+uint16_t sim_tbiv(void);
+uintptr_t *sim_dma_addr(int ch, int dst);
+
+#define SIM_REG16(r)  (*sim_reg16(SIM_R16_##r))
+#define SIM_REG8(r)   (*sim_reg8(SIM_R8_##r))
+
+/*---------------------------------------------------------------------------*/
+/* Timer A */
+#define TACTL         SIM_REG16(TACTL)
+#define TAR           SIM_REG16(TAR)
+#define TACCTL0       SIM_REG16(TACCTL0)
+#define TACCTL1       SIM_REG16(TACCTL1)
+#define TACCTL2       SIM_REG16(TACCTL2)
+#define TACCR0        SIM_REG16(TACCR0)
+#define TACCR1        SIM_REG16(TACCR1)
+#define TACCR2        SIM_REG16(TACCR2)
+#define CCTL0         TACCTL0
+#define CCTL1         TACCTL1
+#define CCTL2         TACCTL2
+#define CCR0          TACCR0
+#define CCR1          TACCR1
+#define CCR2          TACCR2
+#define TAIV          (sim_taiv())
+
+/* Timer B */
+#define TBCTL         SIM_REG16(TBCTL)
+#define TBR           SIM_REG16(TBR)
+#define TBCCTL0       SIM_REG16(TBCCTL0)
+#define TBCCTL1       SIM_REG16(TBCCTL1)
+#define TBCCTL2       SIM_REG16(TBCCTL2)
+#define TBCCTL3       SIM_REG16(TBCCTL3)
+#define TBCCTL4       SIM_REG16(TBCCTL4)
+#define TBCCTL5       SIM_REG16(TBCCTL5)
+#define TBCCTL6       SIM_REG16(TBCCTL6)
+#define TBCCR0        SIM_REG16(TBCCR0)
+#define TBCCR1        SIM_REG16(TBCCR1)
+#define TBCCR2        SIM_REG16(TBCCR2)
+#define TBCCR3        SIM_REG16(TBCCR3)
+#define TBCCR4        SIM_REG16(TBCCR4)
+#define TBCCR5        SIM_REG16(TBCCR5)
+#define TBCCR6        SIM_REG16(TBCCR6)
+#define TBIV          (sim_tbiv())
+
+/* Timer_A/Timer_B control bits */
+#define TASSEL1       0x0200
+#define TASSEL0       0x0100
+#define TBSSEL1       0x0200
+#define TBSSEL0       0x0100
+#define ID1           0x0080
+#define ID0           0x0040
+#define MC1           0x0020
+#define MC0           0x0010
+#define TACLR         0x0004
+#define TBCLR         0x0004
+#define TAIE          0x0002
+#define TBIE          0x0002
+#define TAIFG         0x0001
+#define TBIFG         0x0001
+#define ID_0          (0 * 0x40u)
+#define ID_1          (1 * 0x40u)
+#define ID_2          (2 * 0x40u)
+#define ID_3          (3 * 0x40u)
+#define MC_0          (0 * 0x10u)
+#define MC_1          (1 * 0x10u)
+#define MC_2          (2 * 0x10u)
+#define MC_3          (3 * 0x10u)
+
+/* Capture/compare control bits */
+#define CM1           0x8000
+#define CM0           0x4000
+#define CCIS1         0x2000
+#define CCIS0         0x1000
+#define SCS           0x0800
+#define SCCI          0x0400
+#define CAP           0x0100
+#define OUTMOD2       0x0080
+#define OUTMOD1       0x0040
+#define OUTMOD0       0x0020
+#define CCIE          0x0010
+#define CCI           0x0008
+#define OUT           0x0004
+#define COV           0x0002
+#define CCIFG         0x0001
+#define CM_0          (0 * 0x4000u)
+#define CM_1          (1 * 0x4000u)
+#define CM_2          (2 * 0x4000u)
+#define CM_3          (3 * 0x4000u)
+
+/* Interrupt vector register values */
+#define TAIV_NONE     0x0000
+#define TAIV_CCR1     0x0002
+#define TAIV_CCR2     0x0004
+#define TAIV_OVERFLOW 0x000A
+#define TBIV_NONE     0x0000
+#define TBIV_CCR1     0x0002
+#define TBIV_CCR2     0x0004
+#define TBIV_CCR3     0x0006
+#define TBIV_CCR4     0x0008
+#define TBIV_CCR5     0x000A
+#define TBIV_CCR6     0x000C
+#define TBIV_OVERFLOW 0x000E
+#define TBIV_TBCCR1   TBIV_CCR1
+#define TBIV_TBCCR2   TBIV_CCR2
+#define TBIV_TBCCR3   TBIV_CCR3
+#define TBIV_TBCCR4   TBIV_CCR4
+#define TBIV_TBCCR5   TBIV_CCR5
+#define TBIV_TBCCR6   TBIV_CCR6
+#define TBIV_TBIFG    TBIV_OVERFLOW
+
+/*---------------------------------------------------------------------------*/
+/* Special function registers */
+#define IE1           SIM_REG8(IE1)
+#define IE2           SIM_REG8(IE2)
+#define IFG1          SIM_REG8(IFG1)
+#define IFG2          SIM_REG8(IFG2)
+#define ME1           SIM_REG8(ME1)
+#define ME2           SIM_REG8(ME2)
+
+#define WDTIE         0x01
+#define OFIE          0x02
+#define NMIIE         0x10
+#define ACCVIE        0x20
+#define URXIE0        0x40
+#define UTXIE0        0x80
+#define WDTIFG        0x01
+#define OFIFG         0x02
+#define NMIIFG        0x10
+#define URXIFG0       0x40
+#define UTXIFG0       0x80
+#define URXE0         0x40
+#define USPIE0        0x40
+#define UTXE0         0x80
+#define URXIE1        0x10
+#define UTXIE1        0x20
+#define URXIFG1       0x10
+#define UTXIFG1       0x20
+#define URXE1         0x10
+#define USPIE1        0x10
+#define UTXE1         0x20
+
+/* Digital I/O */
+#define P1IN          SIM_REG8(P1IN)
+#define P1OUT         SIM_REG8(P1OUT)
+#define P1DIR         SIM_REG8(P1DIR)
+#define P1SEL         SIM_REG8(P1SEL)
+#define P1IE          SIM_REG8(P1IE)
+#define P1IES         SIM_REG8(P1IES)
+#define P1IFG         SIM_REG8(P1IFG)
+#define P2IN          SIM_REG8(P2IN)
+#define P2OUT         SIM_REG8(P2OUT)
+#define P2DIR         SIM_REG8(P2DIR)
+#define P2SEL         SIM_REG8(P2SEL)
+#define P2IE          SIM_REG8(P2IE)
+#define P2IES         SIM_REG8(P2IES)
+#define P2IFG         SIM_REG8(P2IFG)
+#define P3IN          SIM_REG8(P3IN)
+#define P3OUT         SIM_REG8(P3OUT)
+#define P3DIR         SIM_REG8(P3DIR)
+#define P3SEL         SIM_REG8(P3SEL)
+#define P4IN          SIM_REG8(P4IN)
+#define P4OUT         SIM_REG8(P4OUT)
+#define P4DIR         SIM_REG8(P4DIR)
+#define P4SEL         SIM_REG8(P4SEL)
+#define P5IN          SIM_REG8(P5IN)
+#define P5OUT         SIM_REG8(P5OUT)
+#define P5DIR         SIM_REG8(P5DIR)
+#define P5SEL         SIM_REG8(P5SEL)
+#define P6IN          SIM_REG8(P6IN)
+#define P6OUT         SIM_REG8(P6OUT)
+#define P6DIR         SIM_REG8(P6DIR)
+#define P6SEL         SIM_REG8(P6SEL)
+
+/* USART0 and USART1 */
+#define U0CTL         SIM_REG8(U0CTL)
+#define U0TCTL        SIM_REG8(U0TCTL)
+#define U0RCTL        SIM_REG8(U0RCTL)
+#define U0MCTL        SIM_REG8(U0MCTL)
+#define U0BR0         SIM_REG8(U0BR0)
+#define U0BR1         SIM_REG8(U0BR1)
+#define U0RXBUF       SIM_REG8(U0RXBUF)
+#define U0TXBUF       SIM_REG16(U0TXBUF)
+#define UCTL0         U0CTL
+#define UTCTL0        U0TCTL
+#define URCTL0        U0RCTL
+#define UMCTL0        U0MCTL
+#define UBR00         U0BR0
+#define UBR10         U0BR1
+#define RXBUF0        U0RXBUF
+#define TXBUF0        U0TXBUF
+#define U1CTL         SIM_REG8(U1CTL)
+#define U1TCTL        SIM_REG8(U1TCTL)
+#define U1RCTL        SIM_REG8(U1RCTL)
+#define U1MCTL        SIM_REG8(U1MCTL)
+#define U1BR0         SIM_REG8(U1BR0)
+#define U1BR1         SIM_REG8(U1BR1)
+#define U1RXBUF       SIM_REG8(U1RXBUF)
+#define U1TXBUF       SIM_REG16(U1TXBUF)
+#define UCTL1         U1CTL
+#define UTCTL1        U1TCTL
+#define URCTL1        U1RCTL
+#define UMCTL1        U1MCTL
+#define UBR01         U1BR0
+#define UBR11         U1BR1
+#define RXBUF1        U1RXBUF
+#define TXBUF1        U1TXBUF
+
+#define PENA          0x80
+#define PEV           0x40
+#define SPB           0x20
+#define CHAR          0x10
+#define LISTEN        0x08
+#define SYNC          0x04
+#define MM            0x02
+#define SWRST         0x01
+#define CKPH          0x80
+#define CKPL          0x40
+#define SSEL1         0x20
+#define SSEL0         0x10
+#define URXSE         0x08
+#define TXWAKE        0x04
+#define STC           0x02
+#define TXEPT         0x01
+#define FE            0x80
+#define PE            0x40
+#define OE            0x20
+#define BRK           0x10
+#define URXEIE        0x08
+#define URXWIE        0x04
+#define RXWAKE        0x02
+#define RXERR         0x01
+
+/* Basic clock module */
+#define DCOCTL        SIM_REG8(DCOCTL)
+#define BCSCTL1       SIM_REG8(BCSCTL1)
+#define BCSCTL2       SIM_REG8(BCSCTL2)
+#define XT2OFF        0x80
+#define XTS           0x40
+#define DIVA1         0x20
+#define DIVA0         0x10
+
+/* Comparator A */
+#define CACTL1        SIM_REG8(CACTL1)
+#define CACTL2        SIM_REG8(CACTL2)
+#define CAIE          0x02
+
+/* Watchdog */
+#define WDTCTL        SIM_REG16(WDTCTL)
+#define WDTPW         0x5A00
+#define WDTHOLD       0x0080
+#define WDTNMIES      0x0040
+#define WDTNMI        0x0020
+#define WDTTMSEL      0x0010
+#define WDTCNTCL      0x0008
+#define WDTSSEL       0x0004
+#define WDTIS1        0x0002
+#define WDTIS0        0x0001
+#define WDT_ARST_1000 (WDTPW + WDTCNTCL + WDTSSEL)
+
+/* DMA */
+#define DMACTL0       SIM_REG16(DMACTL0)
+#define DMACTL1       SIM_REG16(DMACTL1)
+#define DMA0CTL       SIM_REG16(DMA0CTL)
+#define DMA1CTL       SIM_REG16(DMA1CTL)
+#define DMA2CTL       SIM_REG16(DMA2CTL)
+/* The address registers hold host pointers, so they are wider than on
+   the MSP430: write them as (uintptr_t)&object. */
+#define DMA0SA        (*sim_dma_addr(0, 0))
+#define DMA0DA        (*sim_dma_addr(0, 1))
+#define DMA0SZ        SIM_REG16(DMA0SZ)
+#define DMA1SA        (*sim_dma_addr(1, 0))
+#define DMA1DA        (*sim_dma_addr(1, 1))
+#define DMA1SZ        SIM_REG16(DMA1SZ)
+#define DMA2SA        (*sim_dma_addr(2, 0))
+#define DMA2DA        (*sim_dma_addr(2, 1))
+#define DMA2SZ        SIM_REG16(DMA2SZ)
+#define DMA0TSEL_10   0x000A  /* UTXIFG1 */
+#define DMA0TSEL_15   0x000F
+#define DMA1TSEL_4    0x0040  /* UTXIFG0 */
+#define DMA1TSEL_15   0x00F0
+#define DMA2TSEL_15   0x0F00
+#define DMADT_0       0x0000  /* Single transfer */
+#define DMADSTINCR_0  0x0000  /* Destination address unchanged */
+#define DMADSTINCR_3  0x0C00  /* Destination address incremented */
+#define DMASRCINCR_0  0x0000  /* Source address unchanged */
+#define DMASRCINCR_3  0x0300  /* Source address incremented */
+#define DMADSTBYTE    0x0080
+#define DMASRCBYTE    0x0040
+#define DMASBDB       (DMASRCBYTE + DMADSTBYTE)
+#define DMALEVEL      0x0020
+#define DMAEN         0x0010
+#define DMAIFG        0x0008
+#define DMAIE         0x0004
+#define DMAABORT      0x0002
+#define DMAREQ        0x0001
+
+/*---------------------------------------------------------------------------*/
+/* Status register */
+#define GIE           0x0008
+#define CPUOFF        0x0010
+#define OSCOFF        0x0020
+#define SCG0          0x0040
+#define SCG1          0x0080
+#define LPM0_bits     (CPUOFF)
+#define LPM1_bits     (SCG0 + CPUOFF)
+#define LPM2_bits     (SCG1 + CPUOFF)
+#define LPM3_bits     (SCG1 + SCG0 + CPUOFF)
+#define LPM4_bits     (SCG1 + SCG0 + OSCOFF + CPUOFF)
+
+void sim_bis_sr(uint16_t bits);
+void sim_bic_sr(uint16_t bits);
+void sim_bic_sr_irq(uint16_t bits);
+uint16_t sim_read_sr(void);
+void sim_delay_cycles(unsigned long cycles);
+
+#define _BIS_SR(x)          sim_bis_sr(x)
+#define _BIC_SR(x)          sim_bic_sr(x)
+#define _BIS_SR_IRQ(x)      sim_bis_sr(x)
+#define _BIC_SR_IRQ(x)      sim_bic_sr_irq(x)
+#define READ_SR             sim_read_sr()
+#define eint()              sim_bis_sr(GIE)
+#define dint()              sim_bic_sr(GIE)
+#define LPM0                _BIS_SR(LPM0_bits + GIE)
+#define LPM0_EXIT           _BIC_SR_IRQ(LPM0_bits)
+#define LPM3                _BIS_SR(LPM3_bits + GIE)
+#define LPM3_EXIT           _BIC_SR_IRQ(LPM3_bits)
+#define LPM4                _BIS_SR(LPM4_bits + GIE)
+#define LPM4_EXIT           _BIC_SR_IRQ(LPM4_bits)
+#define __delay_cycles(n)   sim_delay_cycles(n)
+
+/*---------------------------------------------------------------------------*/
+/* Interrupt vectors. Interrupt service routines are bound by name
+   (see sim-mcu.c), so the vector numbers only document the priority. */
+#define DACDMA_VECTOR       0
+#define PORT2_VECTOR        2
+#define UART1TX_VECTOR      4
+#define UART1RX_VECTOR      6
+#define PORT1_VECTOR        8
+#define TIMERA1_VECTOR      10
+#define TIMERA0_VECTOR      12
+#define ADC12_VECTOR        14
+#define UART0TX_VECTOR      16
+#define UART0RX_VECTOR      18
+#define WDT_VECTOR          20
+#define COMPARATORA_VECTOR  22
+#define TIMERB1_VECTOR      24
+#define TIMERB0_VECTOR      26
+#define NMI_VECTOR          28
+
+#define interrupt(x)        void
+
+#ifndef BV
+#define BV(x)               (1 << (x))
+#endif
+
+#endif /* LEGACYMSP430_H_ */
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         MSP430 support functions of the sky-sim target, replacing
+ *         cpu/msp430/msp430.c, which relies on inline assembly.
+ */
+
+#include <legacymsp430.h>
+#include <stdint.h>
+#include "msp430contiki.h"
+#include "msp430def.h"
+#include "dev/watchdog.h"
+
+/*---------------------------------------------------------------------------*/
+static void
+init_ports(void)
+{
+  /* Turn everything off, device drivers enable what is needed. */
+  P1SEL = 0;
+  P2SEL = 0;
+  P3SEL = 0;
+  P4SEL = 0;
+  P5SEL = 0;
+  P6SEL = 0;
+
+  P1DIR = 0;
+  P1OUT = 0;
+  P2DIR = 0;
+  P2OUT = 0;
+  P3DIR = 0;
+  P3OUT = 0;
+  P4DIR = 0;
+  P4OUT = 0;
+  P5DIR = 0;
+  P5OUT = 0;
+  P6DIR = 0;
+  P6OUT = 0;
+
+  P1IE = 0;
+  P2IE = 0;
+}
+/*---------------------------------------------------------------------------*/
+#if MSP430_STACK_PAINT
+/* The stack of a node is a block of host memory and malloc() takes host
+   memory as well, accounted for by the simulator (see sim.c). Sizes are
+   those of the host build, not of the msp430 one. */
+void sim_stack_region(char **lo, char **hi);
+unsigned long sim_heap_used(void);
+
+#define STACK_PAINT 0xa5a5
+
+static void
+paint_stack(void)
+{
+  char *lo, *hi, *end;
+  uint16_t *p;
+
+  sim_stack_region(&lo, &hi);
+  /* Stay clear of the frame of this function. */
+  end = (char *)__builtin_frame_address(0) - 256;
+  for(p = (uint16_t *)lo; (char *)p < end; p++) {
+    *p = STACK_PAINT;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static char *
+stack_low(void)
+{
+  char *lo, *hi;
+  uint16_t *p;
+
+  sim_stack_region(&lo, &hi);
+  for(p = (uint16_t *)lo; (char *)p < hi && *p == STACK_PAINT; p++);
+  return (char *)p;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+clamp(unsigned long v)
+{
+  return v > 0xffff ? 0xffff : v;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_stack_max(void)
+{
+  char *lo, *hi;
+
+  sim_stack_region(&lo, &hi);
+  return clamp(hi - stack_low());
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_stack_margin(void)
+{
+  char *lo, *hi;
+
+  sim_stack_region(&lo, &hi);
+  return clamp(stack_low() - lo);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+msp430_heap_used(void)
+{
+  return clamp(sim_heap_used());
+}
+#endif /* MSP430_STACK_PAINT */
+/*---------------------------------------------------------------------------*/
+void
+msp430_cpu_init(void)
+{
+  /* The simulated DCO runs at MSP430_CPU_SPEED from the start. */
+  dint();
+  watchdog_init();
+  init_ports();
+#if MSP430_STACK_PAINT
+  paint_stack();
+#endif /* MSP430_STACK_PAINT */
+  eint();
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Mask all interrupts that can be masked.
+ */
+int
+splhigh_(void)
+{
+  int sr = READ_SR;
+  dint();
+  return sr & GIE;		/* Ignore other sr bits. */
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Restore previous interrupt mask.
+ */
+void
+splx_(int sr)
+{
+  /* If GIE was set, restore it. */
+  _BIS_SR(sr & GIE);
+}
+/*---------------------------------------------------------------------------*/
+void
+msp430_sync_dco(void) {
+  uint16_t last;
+  uint16_t diff;
+#define DELTA_2    ((MSP430_CPU_SPEED) / 32768)
+
+  /* Capture on ACLK for TBCCR6 */
+  TBCCTL6 = CCIS0 + CM0 + CAP;
+  /* start the timer (it should be already started when using Glossy) */
+  TBCTL |= MC1;
+
+  // wait for next Capture
+  TBCCTL6 &= ~CCIFG;
+  while(!(TBCCTL6 & CCIFG));
+  last = TBCCR6;
+
+  TBCCTL6 &= ~CCIFG;
+  // wait for next Capture - and calculate difference
+  while(!(TBCCTL6 & CCIFG));
+  diff = TBCCR6 - last;
+
+  /* The simulated DCO is exact: only account for the adjustment. */
+  if(DELTA_2 < diff) {
+    DCOCTL--;
+  } else if (DELTA_2 > diff) {
+    DCOCTL++;
+  }
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,826 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         MSP430F1611 model of the simulator: register file, Timer A,
+ *         Timer B, interrupts, low-power modes, DMA, USART0 (SPI),
+ *         USART1 (UART transmitter) and the edge interrupt of P1.0
+ *         (FIFOP).
+ *
+ *         The firmware runs natively on the host, so the only notion
+ *         of execution time is the number of cycles charged for each
+ *         access to a peripheral register (SIM_IO_CYCLES), for
+ *         interrupt entry and exit, for explicit delays and for
+ *         memcpy() (see sim_memcpy()).
+ *         Interrupts are served exactly at the cycle in which they
+ *         are requested, which makes the interrupt latency constant.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#define TXBUF_EMPTY 0x100
+
+/* DMA trigger sources (DMAxTSEL). */
+#define DMA_TSEL_UTXIFG0 4
+#define DMA_TSEL_UTXIFG1 10
+
+struct sim_node *sim_cur;
+
+/* Interrupt service routines, bound by name to the firmware. */
+extern void timera0(void) __attribute__((weak));
+extern void timera1(void) __attribute__((weak));
+extern void timerb0(void) __attribute__((weak));
+extern void timerb1_interrupt(void) __attribute__((weak));
+extern void port1_interrupt(void) __attribute__((weak));
+extern void uart1_rx_interrupt(void) __attribute__((weak));
+extern void uart1_tx_interrupt(void) __attribute__((weak));
+extern void dma_interrupt(void) __attribute__((weak));
+
+static void timer_schedule(struct sim_node *n, struct sim_timer *t);
+/*---------------------------------------------------------------------------*/
+static inline void
+hw_set16(struct sim_node *n, int r, uint16_t v)
+{
+  n->r16[r] = v;
+  if(r < SIM_R16_WATCHED) {
+    n->w16[r] = v;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static inline uint64_t
+src_count(const struct sim_timer *t, uint64_t cyc)
+{
+  return t->src == 1 ? cyc >> 7 : cyc;
+}
+/*---------------------------------------------------------------------------*/
+static inline uint64_t
+src_cycle(const struct sim_timer *t, uint64_t cnt)
+{
+  return t->src == 1 ? cnt << 7 : cnt;
+}
+/*---------------------------------------------------------------------------*/
+static inline uint16_t
+timer_value(const struct sim_timer *t, uint64_t cyc)
+{
+  if(t->src == 0) {
+    return t->base_val;
+  }
+  return t->base_val + (uint16_t)(src_count(t, cyc) - t->base_cnt);
+}
+/*---------------------------------------------------------------------------*/
+/* First cycle after cyc at which the counter becomes v. */
+static uint64_t
+timer_match(const struct sim_timer *t, uint64_t cyc, uint16_t v)
+{
+  uint32_t d;
+  if(t->src == 0) {
+    return SIM_NEVER;
+  }
+  d = (uint16_t)(v - timer_value(t, cyc));
+  if(d == 0) {
+    d = 0x10000;
+  }
+  return src_cycle(t, src_count(t, cyc) + d);
+}
+/*---------------------------------------------------------------------------*/
+/* Capture/compare blocks whose CCIxB input is ACLK. */
+static int
+aclk_input(const struct sim_node *n, const struct sim_timer *t, int i)
+{
+  return (t == &n->ta && i == 2) || (t == &n->tb && i == 6);
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_capture(struct sim_node *n, struct sim_timer *t, int i, uint64_t cyc)
+{
+  uint16_t cctl = n->r16[t->cctl + i];
+  if(cctl & CCIFG) {
+    cctl |= COV;
+  }
+  hw_set16(n, t->ccr + i, timer_value(t, cyc));
+  hw_set16(n, t->cctl + i, cctl | CCIFG);
+}
+/*---------------------------------------------------------------------------*/
+/* Capture triggered by software: the input of capture/compare block i
+   is switched between GND (CCIS_2) and VCC (CCIS_3). */
+static void
+timer_sw_capture(struct sim_node *n, struct sim_timer *t, int i,
+                 uint16_t old, uint16_t v)
+{
+  if(!(v & CAP) || !(old & v & CCIS1) || !((old ^ v) & CCIS0)) {
+    return;
+  }
+  if(((v & CCIS0) && (v & CM_1)) || (!(v & CCIS0) && (v & CM_2))) {
+    timer_capture(n, t, i, n->cyc);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_schedule(struct sim_node *n, struct sim_timer *t)
+{
+  int i;
+  uint64_t cyc = n->cyc;
+
+  for(i = 0; i < t->ncc; i++) {
+    uint16_t cctl = n->r16[t->cctl + i];
+    if(cctl & CAP) {
+      if((cctl & (CCIS1 | CCIS0)) == CCIS0 && (cctl & CM_1) &&
+         aclk_input(n, t, i)) {
+        /* Rising edge of ACLK. */
+        t->ev[i] = ((cyc >> 7) + 1) << 7;
+      } else {
+        /* External inputs (SFD) are driven by the radio. */
+        t->ev[i] = SIM_NEVER;
+      }
+    } else {
+      t->ev[i] = timer_match(t, cyc, n->r16[t->ccr + i]);
+    }
+  }
+  t->ovf = timer_match(t, cyc, 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_config(struct sim_node *n, struct sim_timer *t)
+{
+  uint16_t ctl = n->r16[t->ctl];
+  uint16_t v = timer_value(t, n->cyc);
+
+  if(ctl & TACLR) {
+    v = 0;
+    ctl &= ~TACLR;
+    hw_set16(n, t->ctl, ctl);
+  }
+  if((ctl & (MC1 | MC0)) == 0) {
+    t->src = 0;
+  } else if(ctl & TASSEL1) {
+    t->src = 2;
+  } else if(ctl & TASSEL0) {
+    t->src = 1;
+  } else {
+    /* TACLK/TBCLK is not connected. */
+    t->src = 0;
+  }
+  t->base_val = v;
+  t->base_cnt = src_count(t, n->cyc);
+  timer_schedule(n, t);
+}
+/*---------------------------------------------------------------------------*/
+static void
+timer_events(struct sim_node *n, struct sim_timer *t)
+{
+  int i;
+  uint64_t now = n->cyc;
+
+  for(i = 0; i < t->ncc; i++) {
+    uint64_t e = t->ev[i];
+    if(e > now) {
+      continue;
+    }
+    if(n->r16[t->cctl + i] & CAP) {
+      timer_capture(n, t, i, e);
+      t->ev[i] = e + 128;
+    } else {
+      hw_set16(n, t->cctl + i, n->r16[t->cctl + i] | CCIFG);
+      t->ev[i] = src_cycle(t, src_count(t, e) + 0x10000);
+    }
+  }
+  if(t->ovf <= now) {
+    hw_set16(n, t->ctl, n->r16[t->ctl] | TAIFG);
+    t->ovf = src_cycle(t, src_count(t, t->ovf) + 0x10000);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_mcu_sfd_edge(struct sim_node *n, uint64_t cyc, int rising)
+{
+  uint16_t cctl = n->r16[SIM_R16_TBCCTL1];
+
+  if(!(cctl & CAP) || (cctl & (CCIS1 | CCIS0)) != 0) {
+    return;
+  }
+  if((rising && (cctl & CM_1)) || (!rising && (cctl & CM_2))) {
+    timer_capture(n, &n->tb, 1, cyc);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Whether an enabled DMA channel is triggered by tsel. */
+static int
+dma_armed(const struct sim_node *n, unsigned tsel)
+{
+  int ch;
+
+  for(ch = 0; ch < 3; ch++) {
+    if((n->r16[SIM_R16_DMA0CTL + ch] & DMAEN) &&
+       ((n->r16[SIM_R16_DMACTL0] >> (4 * ch)) & 0xf) == tsel) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_mcu_update_next_event(struct sim_node *n)
+{
+  int i;
+  uint64_t e = sim_radio_next_event(n);
+
+  for(i = 0; i < n->ta.ncc; i++) {
+    if(n->ta.ev[i] < e) {
+      e = n->ta.ev[i];
+    }
+  }
+  for(i = 0; i < n->tb.ncc; i++) {
+    if(n->tb.ev[i] < e) {
+      e = n->tb.ev[i];
+    }
+  }
+  if(n->ta.ovf < e) {
+    e = n->ta.ovf;
+  }
+  if(n->tb.ovf < e) {
+    e = n->tb.ovf;
+  }
+  if(n->uart_pending >= 0 && n->uart_done < e) {
+    e = n->uart_done;
+  }
+  if(n->radio.spi_pending >= 0 && n->radio.spi_done < e && n->spi_dma) {
+    e = n->radio.spi_done;
+  }
+  if(n->r8[SIM_R8_P1IE] & 0x01) {
+    uint64_t f = sim_radio_fifop_rise(n);
+    if(f < e) {
+      e = f;
+    }
+  }
+  n->next_event = e;
+}
+/*---------------------------------------------------------------------------*/
+static void
+uart_transmit(struct sim_node *n, uint8_t c)
+{
+  unsigned ubr = n->r8[SIM_R8_U1BR0] | (n->r8[SIM_R8_U1BR1] << 8);
+
+  n->r8[SIM_R8_IFG2] &= ~UTXIFG1;
+  if(!(n->r8[SIM_R8_ME2] & UTXE1)) {
+    /* Transmitter disabled: the byte waits in TXBUF1. */
+    n->uart_held = c;
+    return;
+  }
+  if(n->uart_pending >= 0) {
+    /* The firmware did not wait for UTXIFG1: do not lose the byte. */
+    sim_output(n, n->uart_pending);
+  }
+  if(ubr == 0) {
+    ubr = SIM_F_CPU / 115200;
+  }
+  n->uart_pending = c;
+  n->uart_done = n->cyc + 10 * ubr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+spi_complete(struct sim_node *n)
+{
+  int b = n->radio.spi_pending;
+  n->radio.spi_pending = -1;
+  n->spi_dma = 0;
+  sim_radio_spi_byte(n, b);
+}
+/*---------------------------------------------------------------------------*/
+/* A byte written to TXBUF0 is shifted out in SIM_SPI_BYTE_CYCLES. Its
+   effect on the radio is applied when the firmware waits for it (see
+   sim_spi_wait()), or on time if a DMA transfer is involved. */
+static void
+spi_transmit(struct sim_node *n, uint8_t c)
+{
+  if(n->radio.spi_pending >= 0) {
+    spi_complete(n);
+  }
+  n->radio.spi_pending = c;
+  n->radio.spi_done = n->cyc + SIM_SPI_BYTE_CYCLES;
+}
+/*---------------------------------------------------------------------------*/
+/* One transfer on each enabled DMA channel whose trigger is tsel. Only
+   byte transfers are modelled. */
+static void
+dma_trigger(struct sim_node *n, unsigned tsel)
+{
+  struct sim_dma *d;
+  uint16_t ctl;
+  uint8_t b;
+  int ch;
+
+  for(ch = 0; ch < 3; ch++) {
+    ctl = n->r16[SIM_R16_DMA0CTL + ch];
+    if(!(ctl & DMAEN) ||
+       ((n->r16[SIM_R16_DMACTL0] >> (4 * ch)) & 0xf) != tsel) {
+      continue;
+    }
+    d = &n->dma[ch];
+    b = *(uint8_t *)d->sa;
+    if(d->da == (uintptr_t)&n->r16[SIM_R16_U1TXBUF]) {
+      uart_transmit(n, b);
+    } else if(d->da == (uintptr_t)&n->r16[SIM_R16_U0TXBUF]) {
+      spi_transmit(n, b);
+      n->spi_dma = 1;
+    } else {
+      *(uint8_t *)d->da = b;
+    }
+    if((ctl & DMASRCINCR_3) == DMASRCINCR_3) {
+      d->sa++;
+    }
+    if((ctl & DMADSTINCR_3) == DMADSTINCR_3) {
+      d->da++;
+    }
+    n->cyc += SIM_DMA_CYCLES;
+    if(--d->sz == 0) {
+      hw_set16(n, SIM_R16_DMA0CTL + ch, (ctl & ~DMAEN) | DMAIFG);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Edge detection on P1.0 (FIFOP), the only port pin with interrupts. */
+static void
+port1_sample(struct sim_node *n)
+{
+  uint8_t fifop = sim_radio_get_pin(n, 0);
+
+  if(fifop != n->fifop &&
+     fifop == !(n->r8[SIM_R8_P1IES] & 0x01)) {
+    n->r8[SIM_R8_P1IFG] |= 0x01;
+  }
+  n->fifop = fifop;
+}
+/*---------------------------------------------------------------------------*/
+static void
+process_events(struct sim_node *n)
+{
+  timer_events(n, &n->ta);
+  timer_events(n, &n->tb);
+  if(n->uart_pending >= 0 && n->uart_done <= n->cyc) {
+    sim_output(n, n->uart_pending);
+    n->uart_pending = -1;
+    if(n->uart_held < 0) {
+      n->r8[SIM_R8_IFG2] |= UTXIFG1;
+      dma_trigger(n, DMA_TSEL_UTXIFG1);
+    }
+  }
+  if(n->radio.spi_pending >= 0 && n->radio.spi_done <= n->cyc &&
+     n->spi_dma) {
+    /* Nobody waits for the bytes moved by DMA: shift them out on time
+       and let the DMA write the next one. */
+    spi_complete(n);
+    dma_trigger(n, DMA_TSEL_UTXIFG0);
+  }
+  sim_radio_process(n);
+  port1_sample(n);
+  sim_mcu_update_next_event(n);
+}
+/*---------------------------------------------------------------------------*/
+static void
+written(struct sim_node *n, int r)
+{
+  uint16_t v = n->r16[r];
+  uint16_t old = n->w16[r];
+  int ch;
+
+  n->w16[r] = v;
+  switch(r) {
+  case SIM_R16_TACTL:
+    timer_config(n, &n->ta);
+    break;
+  case SIM_R16_TBCTL:
+    timer_config(n, &n->tb);
+    break;
+  case SIM_R16_TAR:
+    n->ta.base_val = v;
+    n->ta.base_cnt = src_count(&n->ta, n->cyc);
+    timer_schedule(n, &n->ta);
+    break;
+  case SIM_R16_TBR:
+    n->tb.base_val = v;
+    n->tb.base_cnt = src_count(&n->tb, n->cyc);
+    timer_schedule(n, &n->tb);
+    break;
+  case SIM_R16_U0TXBUF:
+    spi_transmit(n, v & 0xff);
+    n->spi_dma = dma_armed(n, DMA_TSEL_UTXIFG0);
+    hw_set16(n, r, TXBUF_EMPTY);
+    break;
+  case SIM_R16_U1TXBUF:
+    uart_transmit(n, v & 0xff);
+    hw_set16(n, r, TXBUF_EMPTY);
+    break;
+  case SIM_R16_DMA0CTL:
+  case SIM_R16_DMA1CTL:
+  case SIM_R16_DMA2CTL:
+    ch = r - SIM_R16_DMA0CTL;
+    if((v & DMAEN) && !(old & DMAEN)) {
+      /* Enabling the channel loads the block into its working registers. */
+      n->dma[ch].sa = n->dma_addr[ch][0];
+      n->dma[ch].da = n->dma_addr[ch][1];
+      n->dma[ch].sz = n->r16[SIM_R16_DMA0SZ + ch];
+    }
+    break;
+  default:
+    if(r >= SIM_R16_TBCCTL0) {
+      if(r <= SIM_R16_TBCCTL6) {
+        timer_sw_capture(n, &n->tb, r - SIM_R16_TBCCTL0, old, v);
+      }
+      timer_schedule(n, &n->tb);
+    } else {
+      if(r >= SIM_R16_TACCTL0 && r <= SIM_R16_TACCTL2) {
+        timer_sw_capture(n, &n->ta, r - SIM_R16_TACCTL0, old, v);
+      }
+      timer_schedule(n, &n->ta);
+    }
+    break;
+  }
+  sim_mcu_update_next_event(n);
+}
+/*---------------------------------------------------------------------------*/
+/* Apply the side effects of the writes done since the last access. */
+static inline void
+commit(struct sim_node *n)
+{
+  int r;
+  for(r = 0; r < SIM_R16_WATCHED; r++) {
+    if(n->r16[r] != n->w16[r]) {
+      written(n, r);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+isr_none(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+/* Highest-priority pending interrupt, with its service routine. */
+static void (*pending_isr(struct sim_node *n))(void)
+{
+  const uint16_t *r = n->r16;
+  int i;
+
+  if((r[SIM_R16_TBCCTL0] & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+    n->r16[SIM_R16_TBCCTL0] &= ~CCIFG;
+    n->w16[SIM_R16_TBCCTL0] &= ~CCIFG;
+    return timerb0 ? timerb0 : isr_none;
+  }
+  if(timerb1_interrupt) {
+    for(i = 1; i <= 6; i++) {
+      if((r[SIM_R16_TBCCTL0 + i] & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+        return timerb1_interrupt;
+      }
+    }
+    if((r[SIM_R16_TBCTL] & (TBIE | TBIFG)) == (TBIE | TBIFG)) {
+      return timerb1_interrupt;
+    }
+  }
+  if((r[SIM_R16_TACCTL0] & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+    n->r16[SIM_R16_TACCTL0] &= ~CCIFG;
+    n->w16[SIM_R16_TACCTL0] &= ~CCIFG;
+    return timera0 ? timera0 : isr_none;
+  }
+  if(timera1) {
+    for(i = 1; i <= 2; i++) {
+      if((r[SIM_R16_TACCTL0 + i] & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+        return timera1;
+      }
+    }
+    if((r[SIM_R16_TACTL] & (TAIE | TAIFG)) == (TAIE | TAIFG)) {
+      return timera1;
+    }
+  }
+  if(port1_interrupt && (n->r8[SIM_R8_P1IE] & n->r8[SIM_R8_P1IFG])) {
+    return port1_interrupt;
+  }
+  if(uart1_rx_interrupt && (n->r8[SIM_R8_IE2] & URXIE1) &&
+     (n->r8[SIM_R8_IFG2] & URXIFG1)) {
+    return uart1_rx_interrupt;
+  }
+  if((n->r8[SIM_R8_IE2] & UTXIE1) && (n->r8[SIM_R8_IFG2] & UTXIFG1)) {
+    n->r8[SIM_R8_IFG2] &= ~UTXIFG1;
+    return uart1_tx_interrupt ? uart1_tx_interrupt : isr_none;
+  }
+  for(i = 0; i < 3; i++) {
+    if((r[SIM_R16_DMA0CTL + i] & (DMAIE | DMAIFG)) == (DMAIE | DMAIFG)) {
+      return dma_interrupt ? dma_interrupt : isr_none;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dispatch(struct sim_node *n)
+{
+  void (*isr)(void);
+  uint64_t start;
+
+  port1_sample(n);
+  while((n->sr & GIE) && (isr = pending_isr(n)) != NULL) {
+    if(n->isr_depth == sizeof(n->isr_sr) / sizeof(n->isr_sr[0])) {
+      fprintf(stderr, "node %u: interrupt nesting too deep\n", n->id);
+      exit(1);
+    }
+    if(n->sr & CPUOFF) {
+      n->wakeups++;
+    }
+    n->isr_sr[n->isr_depth++] = n->sr;
+    n->sr &= SCG0;
+    start = n->cyc;
+    n->cyc += SIM_IRQ_CYCLES;
+    isr();
+    commit(n);
+    n->cyc += SIM_RETI_CYCLES;
+    n->sr = n->isr_sr[--n->isr_depth];
+    /* Glossy floods run in timerb1_interrupt by design; any other long
+       routine delays the capture of the next SFD edge. */
+    if(isr != timerb1_interrupt && n->cyc - start > n->isr_max) {
+      n->isr_max = n->cyc - start;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_access(unsigned cycles)
+{
+  struct sim_node *n = sim_cur;
+  uint64_t target;
+
+  commit(n);
+  if(n->uart_held >= 0 && n->uart_pending < 0 &&
+     (n->r8[SIM_R8_ME2] & UTXE1)) {
+    /* The transmitter was enabled again. */
+    uart_transmit(n, n->uart_held);
+    n->uart_held = -1;
+    sim_mcu_update_next_event(n);
+  }
+  dispatch(n);
+  target = n->cyc + cycles;
+  while(n->next_event <= target) {
+    /* The access is interrupted by the event and completes afterwards. */
+    uint64_t e = n->next_event;
+    uint64_t left;
+    if(e > n->cyc) {
+      n->cyc = e;
+    }
+    left = target - n->cyc;
+    process_events(n);
+    dispatch(n);
+    target = n->cyc + left;
+  }
+  n->cyc = target;
+  if(n->cyc >= n->limit) {
+    sim_yield();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+sleep(struct sim_node *n)
+{
+  while(n->sr & CPUOFF) {
+    dispatch(n);
+    if(!(n->sr & CPUOFF)) {
+      break;
+    }
+    if(n->next_event >= n->limit) {
+      n->sleeping = 1;
+      sim_yield();
+      n->sleeping = 0;
+      continue;
+    }
+    if(n->next_event > n->cyc) {
+      n->cpuoff += n->next_event - n->cyc;
+      n->cyc = n->next_event;
+    }
+    process_events(n);
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint16_t *
+sim_reg16(int r)
+{
+  struct sim_node *n = sim_cur;
+
+  sim_access(SIM_IO_CYCLES);
+  if(r == SIM_R16_TAR) {
+    hw_set16(n, r, timer_value(&n->ta, n->cyc));
+  } else if(r == SIM_R16_TBR) {
+    hw_set16(n, r, timer_value(&n->tb, n->cyc));
+  }
+  return &n->r16[r];
+}
+/*---------------------------------------------------------------------------*/
+uint8_t *
+sim_reg8(int r)
+{
+  struct sim_node *n = sim_cur;
+
+  sim_access(SIM_IO_CYCLES);
+  switch(r) {
+  case SIM_R8_U1TCTL:
+    if(n->uart_pending >= 0) {
+      n->r8[r] &= ~TXEPT;
+    } else {
+      n->r8[r] |= TXEPT;
+    }
+    break;
+  case SIM_R8_P1IN:
+    n->r8[r] = (sim_radio_get_pin(n, 0) << 0) |
+      (sim_radio_get_pin(n, 3) << 3) | (sim_radio_get_pin(n, 4) << 4);
+    break;
+  case SIM_R8_P4IN:
+    n->r8[r] = (n->r8[SIM_R8_P4OUT] & ~(1 << 1)) | (sim_radio_get_pin(n, 1) << 1);
+    break;
+  case SIM_R8_U0RXBUF:
+    n->r8[r] = sim_spi_rxbuf();
+    break;
+  }
+  return &n->r8[r];
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+read_iv(struct sim_timer *t, int ovf_iv)
+{
+  struct sim_node *n = sim_cur;
+  int i;
+
+  sim_access(SIM_IO_CYCLES);
+  for(i = 1; i < t->ncc; i++) {
+    uint16_t cctl = n->r16[t->cctl + i];
+    if((cctl & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+      hw_set16(n, t->cctl + i, cctl & ~CCIFG);
+      return 2 * i;
+    }
+  }
+  if((n->r16[t->ctl] & (TAIE | TAIFG)) == (TAIE | TAIFG)) {
+    hw_set16(n, t->ctl, n->r16[t->ctl] & ~TAIFG);
+    return ovf_iv;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+uintptr_t *
+sim_dma_addr(int ch, int dst)
+{
+  sim_access(SIM_IO_CYCLES);
+  return &sim_cur->dma_addr[ch][dst];
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+sim_taiv(void)
+{
+  return read_iv(&sim_cur->ta, TAIV_OVERFLOW);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+sim_tbiv(void)
+{
+  return read_iv(&sim_cur->tb, TBIV_OVERFLOW);
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_bis_sr(uint16_t bits)
+{
+  struct sim_node *n = sim_cur;
+
+  sim_access(1);
+  n->sr |= bits;
+  if(n->sr & CPUOFF) {
+    sleep(n);
+  } else {
+    dispatch(n);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_bic_sr(uint16_t bits)
+{
+  sim_access(1);
+  sim_cur->sr &= ~bits;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_bic_sr_irq(uint16_t bits)
+{
+  struct sim_node *n = sim_cur;
+
+  if(n->isr_depth > 0) {
+    n->isr_sr[n->isr_depth - 1] &= ~bits;
+  } else {
+    n->sr &= ~bits;
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+sim_read_sr(void)
+{
+  return sim_cur->sr;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_delay_cycles(unsigned long cycles)
+{
+  sim_access(cycles);
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_spi_wait(void)
+{
+  struct sim_node *n = sim_cur;
+
+  sim_access(1);
+  if(n->radio.spi_pending >= 0) {
+    if(n->radio.spi_done > n->cyc) {
+      sim_access(n->radio.spi_done - n->cyc);
+    }
+    if(n->radio.spi_pending >= 0) {
+      spi_complete(n);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+sim_spi_rxbuf(void)
+{
+  sim_spi_wait();
+  return sim_cur->radio.spi_rx;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_spi_select(int on)
+{
+  sim_spi_wait();
+  sim_radio_spi_select(sim_cur, on);
+}
+/*---------------------------------------------------------------------------*/
+int
+sim_spi_selected(void)
+{
+  return sim_cur->radio.cs;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_mcu_init(struct sim_node *n)
+{
+  int i;
+
+  n->ta.ncc = 3;
+  n->ta.ctl = SIM_R16_TACTL;
+  n->ta.r = SIM_R16_TAR;
+  n->ta.cctl = SIM_R16_TACCTL0;
+  n->ta.ccr = SIM_R16_TACCR0;
+  n->tb.ncc = 7;
+  n->tb.ctl = SIM_R16_TBCTL;
+  n->tb.r = SIM_R16_TBR;
+  n->tb.cctl = SIM_R16_TBCCTL0;
+  n->tb.ccr = SIM_R16_TBCCR0;
+  for(i = 0; i < 7; i++) {
+    n->ta.ev[i] = n->tb.ev[i] = SIM_NEVER;
+  }
+  n->ta.ovf = n->tb.ovf = SIM_NEVER;
+
+  hw_set16(n, SIM_R16_U0TXBUF, TXBUF_EMPTY);
+  hw_set16(n, SIM_R16_U1TXBUF, TXBUF_EMPTY);
+  n->r16[SIM_R16_WDTCTL] = 0x6900;
+  n->r8[SIM_R8_IFG1] = UTXIFG0;
+  n->r8[SIM_R8_IFG2] = UTXIFG1;
+  n->r8[SIM_R8_U0TCTL] = TXEPT;
+  n->r8[SIM_R8_U1TCTL] = TXEPT;
+  n->uart_pending = -1;
+  n->uart_held = -1;
+  n->radio.spi_pending = -1;
+  n->next_event = SIM_NEVER;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,746 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         CC2420 model of the simulator and radio medium.
+ *
+ *         The model covers what the CC2420 driver and Glossy rely on:
+ *         command strobes, configuration registers, TXFIFO and RXFIFO,
+ *         the status byte and the FIFO, FIFOP, CCA and SFD pins.
+ *         Timing follows the datasheet: 192 us of calibration before RX
+ *         and TX, 160 us of preamble and SFD, 32 us per byte on air.
+ *
+ *         A transmission reaches each neighbor with the packet reception
+ *         ratio of the link. Frames with identical content whose SFDs
+ *         arrive within 0.5 us of each other interfere constructively
+ *         (their content is compared at the end of the reception);
+ *         any other overlap corrupts the frame being received.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim.h"
+#include "dev/cc2420_const.h"
+
+#define T_CAL         SIM_US(192)
+#define T_PREAMBLE    SIM_US(160)
+#define T_BYTE        SIM_US(32)
+/** Maximum SFD offset for constructive interference. */
+#define T_CI          (SIM_SECOND / 2000000)
+#define RSSI_VALUE    ((uint8_t)-50)
+#define CORRELATION   108
+/** An STXON within this many cycles after the end of a received frame
+    relays it. */
+#define RELAY_WINDOW  (SIM_F_CPU / 1000)
+
+static uint64_t ev_seq;
+/*---------------------------------------------------------------------------*/
+static struct sim_frame *
+frame_ref(struct sim_frame *f)
+{
+  f->refs++;
+  return f;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_put(struct sim_frame *f)
+{
+  if(f != NULL && --f->refs == 0) {
+    free(f);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static inline int
+ev_before(const struct sim_event *a, const struct sim_event *b)
+{
+  return a->cyc < b->cyc || (a->cyc == b->cyc && a->seq < b->seq);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ev_push(struct sim_node *n, uint64_t t, uint8_t type, struct sim_frame *f)
+{
+  struct sim_radio *r = &n->radio;
+  struct sim_event e;
+  int i;
+
+  if(r->nev == r->maxev) {
+    r->maxev = r->maxev ? 2 * r->maxev : 16;
+    r->ev = realloc(r->ev, r->maxev * sizeof(*r->ev));
+    if(r->ev == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  e.cyc = sim_node_cycle(n, t);
+  e.t = t;
+  e.seq = ev_seq++;
+  e.frame = frame_ref(f);
+  e.type = type;
+  for(i = r->nev++; i > 0 && ev_before(&e, &r->ev[(i - 1) / 2]);
+      i = (i - 1) / 2) {
+    r->ev[i] = r->ev[(i - 1) / 2];
+  }
+  r->ev[i] = e;
+  if(e.cyc < n->next_event) {
+    n->next_event = e.cyc;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct sim_event
+ev_pop(struct sim_radio *r)
+{
+  struct sim_event top = r->ev[0];
+  struct sim_event last = r->ev[--r->nev];
+  int i = 0;
+
+  for(;;) {
+    int c = 2 * i + 1;
+    if(c >= r->nev) {
+      break;
+    }
+    if(c + 1 < r->nev && ev_before(&r->ev[c + 1], &r->ev[c])) {
+      c++;
+    }
+    if(!ev_before(&r->ev[c], &last)) {
+      break;
+    }
+    r->ev[i] = r->ev[c];
+    i = c;
+  }
+  r->ev[i] = last;
+  return top;
+}
+/*---------------------------------------------------------------------------*/
+uint64_t
+sim_radio_next_event(const struct sim_node *n)
+{
+  return n->radio.nev ? n->radio.ev[0].cyc : SIM_NEVER;
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_on(uint8_t state)
+{
+  return state == SIM_RADIO_RX || state == SIM_RADIO_TX_CAL ||
+    state == SIM_RADIO_TX;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_state(struct sim_node *n, uint8_t state, uint64_t t)
+{
+  struct sim_radio *r = &n->radio;
+
+  if(is_on(r->state) && !is_on(state)) {
+    r->on_time += t - r->on_since;
+  } else if(!is_on(r->state) && is_on(state)) {
+    r->on_since = t;
+  }
+  r->state = state;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sfd(struct sim_node *n, uint64_t cyc, int level)
+{
+  if(n->radio.sfd != level) {
+    n->radio.sfd = level;
+    sim_mcu_sfd_edge(n, cyc, level);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving(const struct sim_radio *r)
+{
+  return r->rx_frame != NULL && !r->rx_done;
+}
+/*---------------------------------------------------------------------------*/
+static void
+abort_rx(struct sim_node *n)
+{
+  struct sim_radio *r = &n->radio;
+
+  if(receiving(r)) {
+    sfd(n, n->cyc, 0);
+  }
+  frame_put(r->rx_frame);
+  r->rx_frame = NULL;
+  r->rx_read = 0;
+  r->rx_done = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+abort_tx(struct sim_node *n)
+{
+  struct sim_radio *r = &n->radio;
+
+  if(r->tx_frame == NULL) {
+    return;
+  }
+  if(r->state == SIM_RADIO_TX_CAL) {
+    r->tx_frame->cancelled = 1;
+  } else {
+    r->tx_frame->truncated = 1;
+    sfd(n, n->cyc, 0);
+  }
+  frame_put(r->tx_frame);
+  r->tx_frame = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_rx(struct sim_node *n, uint64_t t)
+{
+  if(n->radio.state != SIM_RADIO_RX) {
+    set_state(n, SIM_RADIO_RX, t);
+    n->radio.rx_ready = t + T_CAL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_tx(struct sim_node *n, uint64_t t)
+{
+  struct sim_radio *r = &n->radio;
+  struct sim_frame *f;
+  int i;
+
+  if(r->state == SIM_RADIO_TX_CAL || r->state == SIM_RADIO_TX) {
+    return;
+  }
+  if(receiving(r)) {
+    /* A completely received frame stays in the RXFIFO. */
+    abort_rx(n);
+  }
+  f = calloc(1, sizeof(*f));
+  if(f == NULL) {
+    perror("calloc");
+    exit(1);
+  }
+  f->refs = 1;
+  f->src = n->idx;
+  f->t_sfd = t + T_CAL + T_PREAMBLE;
+  r->tx_frame = frame_ref(f);
+  set_state(n, SIM_RADIO_TX_CAL, t);
+  ev_push(n, f->t_sfd - SIM_LOOKAHEAD - SIM_US(1), SIM_EV_TX_LOAD, f);
+  ev_push(n, f->t_sfd, SIM_EV_TX_SFD, f);
+  for(i = 0; i < n->nlinks; i++) {
+    struct sim_node *d = &sim_nodes[n->links[i].dst];
+    if((sim_random() & 0xffff) < n->links[i].prr) {
+      ev_push(d, f->t_sfd, SIM_EV_RX_ARRIVAL, f);
+    }
+  }
+  frame_put(f);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The CC2420 reads the TXFIFO while transmitting, and Glossy fills it
+ * after the STXON strobe. The length field is taken from the TXFIFO as
+ * late as the lookahead of the simulator allows, 191 us after STXON.
+ * The remaining bytes are streamed into the frame as they are written;
+ * byte i must be written one lookahead before receivers can read it.
+ */
+static void
+stream_tx(struct sim_node *n, struct sim_frame *f)
+{
+  struct sim_radio *r = &n->radio;
+  uint64_t t = sim_node_time(n, n->cyc);
+
+  while(f->loaded < f->len - 1 && f->loaded < r->txfifo_len) {
+    if(t + SIM_LOOKAHEAD > f->t_sfd + (f->loaded + 1) * T_BYTE) {
+      f->underflow = 1;
+    }
+    f->data[f->loaded] = r->txfifo[f->loaded];
+    f->loaded++;
+  }
+}
+
+static void
+load_tx(struct sim_node *n, struct sim_frame *f)
+{
+  struct sim_radio *r = &n->radio;
+  int len = r->txfifo_len ? r->txfifo[0] & 0x7f : 0;
+
+  f->len = len;
+  f->underflow = len < 2;
+  f->loaded = 0;
+  stream_tx(n, f);
+  f->t_end = f->t_sfd + (len + 1) * T_BYTE;
+  ev_push(n, f->t_end, SIM_EV_TX_END, f);
+}
+/*---------------------------------------------------------------------------*/
+static void
+strobe(struct sim_node *n, uint8_t s)
+{
+  struct sim_radio *r = &n->radio;
+  uint64_t t = sim_node_time(n, n->cyc);
+
+  switch(s) {
+  case CC2420_SXOSCON:
+    r->xosc = 1;
+    if(r->state == SIM_RADIO_OFF) {
+      set_state(n, SIM_RADIO_IDLE, t);
+    }
+    break;
+  case CC2420_SRXON:
+    abort_tx(n);
+    start_rx(n, t);
+    break;
+  case CC2420_STXON:
+  case CC2420_STXONCCA:
+    if(r->xosc) {
+      if(r->state == SIM_RADIO_RX && r->rx_done &&
+         n->cyc - r->rx_end < RELAY_WINDOW &&
+         n->cyc - r->rx_end > r->relay_max) {
+        r->relay_max = n->cyc - r->rx_end;
+      }
+      start_tx(n, t);
+    }
+    break;
+  case CC2420_SRFOFF:
+  case CC2420_SXOSCOFF:
+    abort_tx(n);
+    abort_rx(n);
+    if(s == CC2420_SXOSCOFF) {
+      r->xosc = 0;
+      set_state(n, SIM_RADIO_OFF, t);
+    } else if(r->state != SIM_RADIO_OFF) {
+      set_state(n, SIM_RADIO_IDLE, t);
+    }
+    break;
+  case CC2420_SFLUSHRX:
+    abort_rx(n);
+    break;
+  case CC2420_SFLUSHTX:
+    r->txfifo_len = 0;
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+status(const struct sim_radio *r)
+{
+  uint8_t s = 0;
+
+  if(r->xosc) {
+    s |= BV(CC2420_XOSC16M_STABLE);
+  }
+  if(is_on(r->state)) {
+    s |= BV(CC2420_LOCK);
+  }
+  if(r->state == SIM_RADIO_RX) {
+    s |= BV(CC2420_RSSI_VALID);
+  }
+  if(r->state == SIM_RADIO_TX_CAL || r->state == SIM_RADIO_TX) {
+    s |= BV(CC2420_TX_ACTIVE);
+  }
+  return s;
+}
+/*---------------------------------------------------------------------------*/
+/* Number of bytes of the current frame that reached the RXFIFO. */
+static int
+rx_avail(const struct sim_node *n)
+{
+  const struct sim_radio *r = &n->radio;
+  uint64_t t;
+  int avail;
+
+  if(r->rx_frame == NULL) {
+    return 0;
+  }
+  if(r->rx_done) {
+    return r->rx_frame->len + 1;
+  }
+  t = sim_node_time(n, n->cyc);
+  avail = t > r->rx_start ? (t - r->rx_start) / T_BYTE : 0;
+  return avail > r->rx_frame->len + 1 ? r->rx_frame->len + 1 : avail;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+rxfifo_read(struct sim_node *n)
+{
+  struct sim_radio *r = &n->radio;
+  struct sim_frame *f = r->rx_frame;
+  int i;
+
+  if(f == NULL || r->rx_read >= rx_avail(n)) {
+    return 0;
+  }
+  i = r->rx_read++;
+  if(i < f->len - 1) {
+    return f->data[i];
+  } else if(i == f->len - 1) {
+    return RSSI_VALUE;
+  } else if(r->rx_corrupt || f->cancelled || f->truncated || f->underflow) {
+    return CORRELATION;
+  }
+  return 0x80 | CORRELATION;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_spi_byte(struct sim_node *n, uint8_t b)
+{
+  struct sim_radio *r = &n->radio;
+  uint8_t addr;
+
+  if(!r->cs) {
+    r->spi_rx = 0;
+    return;
+  }
+  if(r->spi_idx == 0 ||
+     (!(r->spi_cmd & 0x80) && (r->spi_cmd & 0x3f) <= CC2420_SAES)) {
+    /* Command byte, or strobe following a strobe. */
+    r->spi_rx = status(r);
+    r->spi_cmd = b;
+    r->spi_idx = 1;
+    if(!(b & 0x80) && (b & 0x3f) <= CC2420_SAES) {
+      strobe(n, b & 0x3f);
+    }
+    return;
+  }
+  r->spi_rx = 0;
+  if(r->spi_cmd & 0x80) {
+    /* RAM access, not modelled. */
+    return;
+  }
+  addr = r->spi_cmd & 0x3f;
+  if(addr == CC2420_TXFIFO) {
+    if(!(r->spi_cmd & 0x40) && r->txfifo_len < sizeof(r->txfifo)) {
+      r->txfifo[r->txfifo_len++] = b;
+      if(r->tx_frame != NULL && r->tx_frame->t_end) {
+        stream_tx(n, r->tx_frame);
+      }
+    }
+    r->spi_rx = status(r);
+  } else if(addr == CC2420_RXFIFO) {
+    if(r->spi_cmd & 0x40) {
+      r->spi_rx = rxfifo_read(n);
+    }
+  } else if(r->spi_idx == 1) {
+    if(r->spi_cmd & 0x40) {
+      r->spi_rx = r->reg[addr] >> 8;
+    }
+    r->spi_word = b << 8;
+    r->spi_idx = 2;
+  } else if(r->spi_idx == 2) {
+    if(r->spi_cmd & 0x40) {
+      r->spi_rx = r->reg[addr] & 0xff;
+    } else {
+      r->reg[addr] = r->spi_word | b;
+    }
+    r->spi_idx = 3;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_spi_select(struct sim_node *n, int on)
+{
+  if(on && !n->radio.cs) {
+    n->radio.spi_idx = 0;
+  }
+  n->radio.cs = on;
+}
+/*---------------------------------------------------------------------------*/
+int
+sim_radio_get_pin(const struct sim_node *n, int pin)
+{
+  const struct sim_radio *r = &n->radio;
+  int unread = rx_avail(n) - r->rx_read;
+
+  switch(pin) {
+  case 0: /* FIFOP */
+    return unread > (r->reg[CC2420_IOCFG0] & 0x7f) ||
+      (r->rx_done && unread > 0);
+  case 1: /* SFD */
+    return r->sfd;
+  case 3: /* FIFO */
+    return unread > 0;
+  case 4: /* CCA */
+    return !receiving(r);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Local cycle at which FIFOP rises as the frame being received fills the
+   RXFIFO, SIM_NEVER if it is already high or only rises at the end of
+   the frame (an event anyway). */
+uint64_t
+sim_radio_fifop_rise(const struct sim_node *n)
+{
+  const struct sim_radio *r = &n->radio;
+  int needed;
+
+  if(r->rx_frame == NULL || r->rx_done || sim_radio_get_pin(n, 0)) {
+    return SIM_NEVER;
+  }
+  needed = r->rx_read + (r->reg[CC2420_IOCFG0] & 0x7f) + 1;
+  if(needed > r->rx_frame->len + 1) {
+    return SIM_NEVER;
+  }
+  return sim_node_cycle(n, r->rx_start + needed * T_BYTE);
+}
+/*---------------------------------------------------------------------------*/
+int
+sim_radio_pin(int pin)
+{
+  sim_access(SIM_IO_CYCLES);
+  return sim_radio_get_pin(sim_cur, pin);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Transmitters stream their frames while they are on air, so the
+ * content of frames that overlap constructively is compared only at
+ * the end of the reception, when both have been completely loaded.
+ */
+static int
+same_content(const struct sim_frame *a, const struct sim_frame *b)
+{
+  return a->len == b->len && !a->underflow && !b->underflow &&
+    a->loaded == b->loaded && a->loaded == a->len - 1 &&
+    memcmp(a->data, b->data, a->loaded) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+ci_push(struct sim_radio *r, struct sim_frame *f)
+{
+  if(r->nci == r->maxci) {
+    r->maxci = r->maxci ? 2 * r->maxci : 8;
+    r->ci = realloc(r->ci, r->maxci * sizeof(*r->ci));
+    if(r->ci == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  r->ci[r->nci++] = frame_ref(f);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ci_clear(struct sim_radio *r)
+{
+  while(r->nci > 0) {
+    frame_put(r->ci[--r->nci]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+rx_arrival(struct sim_node *n, struct sim_event *e)
+{
+  struct sim_radio *r = &n->radio;
+  struct sim_frame *f = e->frame;
+
+  if(f->cancelled || r->state != SIM_RADIO_RX || e->t < r->rx_ready) {
+    return;
+  }
+  if(receiving(r)) {
+    /* Arrivals due in the same local cycle are processed in insertion
+       order, so this SFD may be the earlier one. */
+    uint64_t dt = e->t > r->rx_start ? e->t - r->rx_start : r->rx_start - e->t;
+    if(dt > T_CI || f->len != r->rx_frame->len) {
+      r->rx_corrupt = 1;
+      r->n_collisions++;
+    } else {
+      ci_push(r, f);
+    }
+    return;
+  }
+  ci_clear(r);
+  frame_put(r->rx_frame);
+  r->rx_frame = frame_ref(f);
+  r->rx_start = e->t;
+  r->rx_read = 0;
+  r->rx_done = 0;
+  r->rx_corrupt = 0;
+  sfd(n, e->cyc, 1);
+  ev_push(n, f->t_end, SIM_EV_RX_END, f);
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_process(struct sim_node *n)
+{
+  struct sim_radio *r = &n->radio;
+  int i;
+
+  while(r->nev > 0 && r->ev[0].cyc <= n->cyc) {
+    struct sim_event e = ev_pop(r);
+    struct sim_frame *f = e.frame;
+
+    switch(e.type) {
+    case SIM_EV_TX_LOAD:
+      if(r->tx_frame == f) {
+        load_tx(n, f);
+      }
+      break;
+    case SIM_EV_TX_SFD:
+      if(r->tx_frame == f) {
+        r->state = SIM_RADIO_TX;
+        sfd(n, e.cyc, 1);
+      }
+      break;
+    case SIM_EV_TX_END:
+      if(r->tx_frame == f) {
+        if(f->loaded < f->len - 1) {
+          f->underflow = 1;
+        }
+        sfd(n, e.cyc, 0);
+        frame_put(r->tx_frame);
+        r->tx_frame = NULL;
+        r->state = SIM_RADIO_RX;
+        r->rx_ready = e.t + T_CAL;
+        r->n_tx++;
+      }
+      break;
+    case SIM_EV_RX_ARRIVAL:
+      rx_arrival(n, &e);
+      break;
+    case SIM_EV_RX_END:
+      if(r->rx_frame == f && !r->rx_done) {
+        r->rx_done = 1;
+        r->rx_end = e.cyc;
+        sfd(n, e.cyc, 0);
+        for(i = 0; i < r->nci; i++) {
+          if(!same_content(f, r->ci[i])) {
+            r->rx_corrupt = 1;
+            r->n_collisions++;
+          }
+        }
+        ci_clear(r);
+        if(r->rx_corrupt || f->truncated || f->underflow) {
+          r->n_rx_bad++;
+        } else {
+          r->n_rx_ok++;
+        }
+      }
+      break;
+    }
+    frame_put(f);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_finish(struct sim_node *n, uint64_t t)
+{
+  if(is_on(n->radio.state)) {
+    n->radio.on_time += t - n->radio.on_since;
+    n->radio.on_since = t;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_radio_init(struct sim_node *n)
+{
+  struct sim_radio *r = &n->radio;
+
+  r->state = SIM_RADIO_OFF;
+  r->reg[CC2420_MDMCTRL0] = 0x0ae2;
+  r->reg[CC2420_SYNCWORD] = 0xa70f;
+  r->reg[CC2420_TXCTRL] = 0xa0ff;
+  r->reg[CC2420_RXCTRL0] = 0x12e5;
+  r->reg[CC2420_RXCTRL1] = 0x0a56;
+  r->reg[CC2420_FSCTRL] = 0x4165;
+  r->reg[CC2420_SECCTRL0] = 0x0344;
+  r->reg[CC2420_IOCFG0] = 0x0040;
+  r->reg[CC2420_MANFIDL] = 0x233d;
+  r->reg[CC2420_MANFIDH] = 0x3000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_link(int src, int dst, double prr)
+{
+  struct sim_node *n = &sim_nodes[src];
+
+  n->links = realloc(n->links, (n->nlinks + 1) * sizeof(*n->links));
+  if(n->links == NULL) {
+    perror("realloc");
+    exit(1);
+  }
+  n->links[n->nlinks].dst = dst;
+  n->links[n->nlinks].prr = (uint32_t)(prr * 65536 + 0.5);
+  n->nlinks++;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Connect the nodes: "full" (everyone hears everyone), "line", "grid"
+ * (4-neighborhood, ceil(sqrt(N)) columns), or the name of a file with
+ * one directed link "src dst [prr]" per line, node ids starting at 1.
+ */
+int
+sim_topology(const char *spec, double prr)
+{
+  int i, j, n = sim_num_nodes;
+
+  if(strcmp(spec, "full") == 0) {
+    for(i = 0; i < n; i++) {
+      for(j = 0; j < n; j++) {
+        if(i != j) {
+          add_link(i, j, prr);
+        }
+      }
+    }
+  } else if(strcmp(spec, "line") == 0) {
+    for(i = 0; i + 1 < n; i++) {
+      add_link(i, i + 1, prr);
+      add_link(i + 1, i, prr);
+    }
+  } else if(strcmp(spec, "grid") == 0) {
+    int cols = (int)ceil(sqrt(n));
+    for(i = 0; i < n; i++) {
+      if((i + 1) % cols != 0 && i + 1 < n) {
+        add_link(i, i + 1, prr);
+        add_link(i + 1, i, prr);
+      }
+      if(i + cols < n) {
+        add_link(i, i + cols, prr);
+        add_link(i + cols, i, prr);
+      }
+    }
+  } else {
+    char line[128];
+    FILE *fp = fopen(spec, "r");
+    if(fp == NULL) {
+      perror(spec);
+      return -1;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL) {
+      int src, dst;
+      double p = prr;
+      if(line[0] == '#' || sscanf(line, "%d %d %lf", &src, &dst, &p) < 2) {
+        continue;
+      }
+      if(src < 1 || src > n || dst < 1 || dst > n || src == dst) {
+        fprintf(stderr, "%s: invalid link %d -> %d\n", spec, src, dst);
+        fclose(fp);
+        return -1;
+      }
+      add_link(src - 1, dst - 1, p);
+    }
+    fclose(fp);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
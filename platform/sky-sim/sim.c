@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Discrete-event simulator for networks of Tmote Sky nodes.
+ *
+ *         The unmodified firmware (application, Contiki, Glossy and the
+ *         sky drivers) is compiled for the host and linked once; every
+ *         node runs it in its own coroutine, with its own copy of the
+ *         firmware .data and .bss sections, swapped in whenever the node
+ *         is scheduled. Peripheral registers are backed by the MCU and
+ *         radio models in sim-mcu.c and sim-radio.c.
+ *
+ *         Nodes are executed in windows of SIM_LOOKAHEAD of global time:
+ *         a transmission affects other nodes only 352 us after the
+ *         STXON strobe and its content is fixed SIM_LOOKAHEAD before
+ *         the SFD, so the nodes can run independently within a window
+ *         without violating causality.
+ *
+ *         Usage:
+ *           make TARGET=sky-sim glossy-test
+ *           ./glossy-test.sky-sim -n 20 -t grid -d 60
+ *
+ *         Serial output of each node is printed as
+ *         "<time in s> ID:<node id> <line>". Node 1 is the initiator
+ *         of the Glossy applications.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "sim.h"
+
+#define SIM_STACK_SIZE (64 * 1024)
+
+struct sim_node *sim_nodes;
+int sim_num_nodes;
+int sim_quiet;
+
+/* Firmware sections, see sim-firmware.ld. */
+extern char __start_sim_fw_data[], __stop_sim_fw_data[];
+extern char __start_sim_fw_bss[], __stop_sim_fw_bss[];
+
+/* Firmware symbols, renamed when linking. */
+int sim_node_main(int argc, char **argv);
+int sim_fw_putchar(int c);
+
+static jmp_buf sched_ctx;
+static struct sim_node *image_owner;
+static size_t data_size, bss_size;
+static uint64_t rng_state = 88172645463325252ULL;
+/*---------------------------------------------------------------------------*/
+uint64_t
+sim_node_time(const struct sim_node *n, uint64_t cyc)
+{
+  return n->boot + (uint64_t)((unsigned __int128)cyc * SIM_TICKS_PER_CYCLE *
+                              1000000 / (1000000 + n->ppm));
+}
+/*---------------------------------------------------------------------------*/
+uint64_t
+sim_node_cycle(const struct sim_node *n, uint64_t t)
+{
+  unsigned __int128 x;
+
+  if(t <= n->boot) {
+    return 0;
+  }
+  x = (unsigned __int128)(t - n->boot) * (1000000 + n->ppm);
+  return (uint64_t)((x + SIM_TICKS_PER_CYCLE * 1000000 - 1) /
+                    (SIM_TICKS_PER_CYCLE * 1000000));
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+sim_random(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state >> 32;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_output(struct sim_node *n, uint8_t c)
+{
+  n->uart_bytes++;
+  if(n->uart_log != NULL) {
+    putc(c, n->uart_log);
+  }
+  /* Binary records are sent as SLIP frames (see tools/sky/serialdump.c)
+     between text lines: leave them out of the text output. */
+  if(c == SIM_SLIP_END) {
+    /* an END closes a non-empty frame, otherwise it starts one */
+    n->in_slip = !n->in_slip || n->slip_len == 0;
+    n->slip_len = 0;
+    return;
+  }
+  if(n->in_slip) {
+    n->slip_len++;
+    return;
+  }
+  if(c != '\n' && c != '\r' && n->line_len < sizeof(n->line) - 1) {
+    n->line[n->line_len++] = c;
+  }
+  if(c == '\n') {
+    n->line[n->line_len] = '\0';
+    if(strncmp(n->line, "****", 4) == 0) {
+      n->errors++;
+    }
+    if(!sim_quiet) {
+      printf("%11.6f ID:%u %s\n",
+             (double)sim_node_time(n, n->cyc) / SIM_SECOND, n->id, n->line);
+    }
+    n->line_len = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* C library functions with per-node state or output, called by the
+   firmware. */
+int
+sim_printf(const char *fmt, ...)
+{
+  char buf[256];
+  va_list ap;
+  int i, len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  for(i = 0; buf[i] != '\0'; i++) {
+    sim_fw_putchar((unsigned char)buf[i]);
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+sim_rand(void)
+{
+  /* Same generator and range as the msp430 C library. */
+  sim_cur->rand_state = sim_cur->rand_state * 1103515245 + 12345;
+  return (sim_cur->rand_state >> 16) & 0x7fff;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_srand(unsigned seed)
+{
+  sim_cur->rand_state = seed;
+}
+/*---------------------------------------------------------------------------*/
+void *
+sim_malloc(size_t size)
+{
+  /* The firmware heap is host memory: only account for it. */
+  sim_cur->heap += size;
+  return malloc(size);
+}
+/*---------------------------------------------------------------------------*/
+void *
+sim_memcpy(void *dst, const void *src, size_t n)
+{
+  /* Firmware copies are not free: charge what the msp430-libc routine
+     takes, so that work moved in or out of interrupt context shows. */
+  if(n > 0) {
+    sim_access(SIM_MEMCPY_CYCLES + n *
+               ((((uintptr_t)dst ^ (uintptr_t)src) & 1) ?
+                SIM_MEMCPY_BYTE_CYCLES : SIM_MEMCPY_WORD_CYCLES));
+  }
+  return memcpy(dst, src, n);
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+sim_heap_used(void)
+{
+  return sim_cur->heap;
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_stack_region(char **lo, char **hi)
+{
+  *lo = sim_cur->stack;
+  *hi = (char *)sim_cur->stack + SIM_STACK_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+sim_node_id(void)
+{
+  return sim_cur->id;
+}
+/*---------------------------------------------------------------------------*/
+static void
+image_save(struct sim_node *n)
+{
+  memcpy(n->image, __start_sim_fw_data, data_size);
+  memcpy(n->image + data_size, __start_sim_fw_bss, bss_size);
+}
+/*---------------------------------------------------------------------------*/
+static void
+image_load(const struct sim_node *n)
+{
+  memcpy(__start_sim_fw_data, n->image, data_size);
+  memcpy(__start_sim_fw_bss, n->image + data_size, bss_size);
+}
+/*---------------------------------------------------------------------------*/
+void
+sim_yield(void)
+{
+  if(!_setjmp(sim_cur->ctx)) {
+    _longjmp(sched_ctx, 1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_entry(void)
+{
+  sim_node_main(0, NULL);
+  sim_cur->halted = 1;
+  for(;;) {
+    sim_yield();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+resume(struct sim_node *n)
+{
+  if(image_owner != n) {
+    if(image_owner != NULL) {
+      image_save(image_owner);
+    }
+    image_load(n);
+    image_owner = n;
+  }
+  sim_cur = n;
+  if(!_setjmp(sched_ctx)) {
+    if(!n->started) {
+      n->started = 1;
+      setcontext(&n->uc);
+    }
+    _longjmp(n->ctx, 1);
+  }
+  sim_cur = NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Global time at which the node has something to do. */
+static uint64_t
+next_wake(const struct sim_node *n)
+{
+  if(n->halted) {
+    return SIM_NEVER;
+  }
+  if(!n->started) {
+    return n->boot;
+  }
+  if(n->sleeping) {
+    return n->next_event == SIM_NEVER ?
+      SIM_NEVER : sim_node_time(n, n->next_event);
+  }
+  return sim_node_time(n, n->cyc);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(uint64_t end)
+{
+  uint64_t *wake = malloc(sim_num_nodes * sizeof(*wake));
+  int i;
+
+  for(;;) {
+    uint64_t min = SIM_NEVER, h;
+    for(i = 0; i < sim_num_nodes; i++) {
+      wake[i] = next_wake(&sim_nodes[i]);
+      if(wake[i] < min) {
+        min = wake[i];
+      }
+    }
+    if(min >= end) {
+      break;
+    }
+    h = min + SIM_LOOKAHEAD;
+    for(i = 0; i < sim_num_nodes; i++) {
+      if(wake[i] < h) {
+        sim_nodes[i].limit = sim_node_cycle(&sim_nodes[i], h);
+        resume(&sim_nodes[i]);
+      }
+    }
+  }
+  free(wake);
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_init(struct sim_node *n, int idx, int max_ppm, uint64_t max_boot,
+          const char *uart_log)
+{
+  n->idx = idx;
+  n->id = idx + 1;
+  n->ppm = max_ppm ? (int32_t)(sim_random() % (2 * max_ppm + 1)) - max_ppm : 0;
+  n->boot = max_boot ? ((uint64_t)sim_random() << 32 | sim_random()) %
+    max_boot : 0;
+  n->rand_state = sim_random();
+  n->image = malloc(data_size + bss_size);
+  n->stack = malloc(SIM_STACK_SIZE);
+  if(n->image == NULL || n->stack == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  memcpy(n->image, __start_sim_fw_data, data_size);
+  memset(n->image + data_size, 0, bss_size);
+  getcontext(&n->uc);
+  n->uc.uc_stack.ss_sp = n->stack;
+  n->uc.uc_stack.ss_size = SIM_STACK_SIZE;
+  n->uc.uc_link = NULL;
+  makecontext(&n->uc, node_entry, 0);
+  if(uart_log != NULL) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s%u", uart_log, n->id);
+    n->uart_log = fopen(name, "wb");
+    if(n->uart_log == NULL) {
+      perror(name);
+      exit(1);
+    }
+  }
+  sim_mcu_init(n);
+  sim_radio_init(n);
+}
+/*---------------------------------------------------------------------------*/
+static int
+summary(uint64_t end, double wall)
+{
+  uint64_t on = 0;
+  uint32_t tx = 0, rx = 0, bad = 0, collisions = 0, errors = 0;
+  int i;
+
+  printf("# node  radio-on[ms]  duty[%%]     tx     rx  rx-bad  collisions  uart[B]  wakeups  isr-max[us]  relay[cyc]  cpu[ms]\n");
+  for(i = 0; i < sim_num_nodes; i++) {
+    struct sim_node *n = &sim_nodes[i];
+    struct sim_radio *r = &n->radio;
+    sim_radio_finish(n, end);
+    printf("# %4u  %12.3f  %7.3f  %5u  %5u  %6u  %10u  %8u  %7u  %11.1f  %10u  %7.1f\n", n->id,
+           (double)r->on_time * 1000 / SIM_SECOND,
+           100.0 * r->on_time / end, r->n_tx, r->n_rx_ok, r->n_rx_bad,
+           r->n_collisions, n->uart_bytes, n->wakeups,
+           (double)n->isr_max * 1e6 / SIM_F_CPU, r->relay_max,
+           (double)(n->cyc - n->cpuoff) * 1000 / SIM_F_CPU);
+    if(n->uart_log != NULL) {
+      fclose(n->uart_log);
+    }
+    on += r->on_time;
+    tx += r->n_tx;
+    rx += r->n_rx_ok;
+    bad += r->n_rx_bad;
+    collisions += r->n_collisions;
+    errors += n->errors;
+  }
+  printf("# %d nodes, %.3f s simulated in %.3f s (%.1fx real time)\n",
+         sim_num_nodes, (double)end / SIM_SECOND, wall,
+         wall > 0 ? (double)end / SIM_SECOND / wall : 0);
+  printf("# average duty cycle %.3f%%, %u tx, %u rx, %u rx-bad\n",
+         100.0 * on / end / sim_num_nodes, tx, rx, bad);
+  if(collisions > 0 || errors > 0) {
+    printf("# %u collisions, %u error lines (\"****\")\n", collisions, errors);
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [-n nodes] [-t full|line|grid|<file>] [-p prr] "
+          "[-d seconds]\n"
+          "       [-s seed] [-k ppm] [-b ms] [-u prefix] [-q] [-c]\n"
+          "  -n  number of nodes (default 10), node 1 is the initiator\n"
+          "  -t  topology (default full); a file has one directed link\n"
+          "      \"src dst [prr]\" per line\n"
+          "  -p  packet reception ratio of the links (default 1.0)\n"
+          "  -d  simulated time in seconds (default 10)\n"
+          "  -s  random seed (default 1)\n"
+          "  -k  maximum clock drift in ppm (default 40)\n"
+          "  -b  nodes boot at random within this many ms (default 100)\n"
+          "  -u  write the raw serial output of node <id> to file <prefix><id>\n"
+          "  -q  do not print the serial output of the nodes\n"
+          "  -c  check: exit with status 2 if a node counted a collision or\n"
+          "      printed an error line (starting with \"****\")\n", prog);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *topo = "full", *uart_log = NULL;
+  double prr = 1.0, duration = 10, max_boot_ms = 100;
+  int opt, i, max_ppm = 40, check = 0, failed;
+  unsigned long seed = 1;
+  struct timespec t0, t1;
+  uint64_t end;
+
+  sim_num_nodes = 10;
+  while((opt = getopt(argc, argv, "n:t:p:d:s:k:b:u:qch")) != -1) {
+    switch(opt) {
+    case 'n':
+      sim_num_nodes = atoi(optarg);
+      break;
+    case 't':
+      topo = optarg;
+      break;
+    case 'p':
+      prr = atof(optarg);
+      break;
+    case 'd':
+      duration = atof(optarg);
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 0);
+      break;
+    case 'k':
+      max_ppm = atoi(optarg);
+      break;
+    case 'b':
+      max_boot_ms = atof(optarg);
+      break;
+    case 'u':
+      uart_log = optarg;
+      break;
+    case 'q':
+      sim_quiet = 1;
+      break;
+    case 'c':
+      check = 1;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if(sim_num_nodes < 1 || sim_num_nodes > 65535 || prr < 0 || prr > 1 ||
+     duration <= 0 || max_ppm < 0 || max_boot_ms < 0) {
+    usage(argv[0]);
+  }
+  rng_state ^= seed * 0x9e3779b97f4a7c15ULL;
+  sim_random();
+
+  data_size = __stop_sim_fw_data - __start_sim_fw_data;
+  bss_size = __stop_sim_fw_bss - __start_sim_fw_bss;
+  sim_nodes = calloc(sim_num_nodes, sizeof(*sim_nodes));
+  if(sim_nodes == NULL) {
+    perror("calloc");
+    return 1;
+  }
+  for(i = 0; i < sim_num_nodes; i++) {
+    node_init(&sim_nodes[i], i, max_ppm,
+              (uint64_t)(max_boot_ms * SIM_SECOND / 1000), uart_log);
+  }
+  if(sim_topology(topo, prr) < 0) {
+    return 1;
+  }
+
+  end = (uint64_t)(duration * SIM_SECOND);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  run(end);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  failed = summary(end, (t1.tv_sec - t0.tv_sec) +
+                   (t1.tv_nsec - t0.tv_nsec) / 1e9);
+  return check && failed ? 2 : 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Discrete-event simulator for networks of Tmote Sky nodes,
+ *         internal header shared by sim.c, sim-mcu.c and sim-radio.c.
+ *
+ *         Global simulation time is counted in ticks of 1/16 of a
+ *         nominal DCO cycle. Each node keeps its own DCO cycle counter,
+ *         which runs at (1e6 + ppm) / 1e6 times the nominal rate;
+ *         ACLK is the DCO divided by 128 (32768 Hz).
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <ucontext.h>
+
+#include "legacymsp430.h"
+
+#define SIM_F_CPU               4194304ULL
+#define SIM_TICKS_PER_CYCLE     16ULL
+#define SIM_SECOND              (SIM_F_CPU * SIM_TICKS_PER_CYCLE)
+#define SIM_US(us)              ((uint64_t)(us) * SIM_SECOND / 1000000ULL)
+#define SIM_NEVER               UINT64_MAX
+
+/** Minimum delay between an action of a node and its effect on another
+    node: nodes run independently within windows of this length. */
+#define SIM_LOOKAHEAD           SIM_US(160)
+
+/** SLIP frame delimiter on the serial line. */
+#define SIM_SLIP_END            0300
+
+/** DCO cycles charged for each access to a peripheral register. */
+#define SIM_IO_CYCLES           3
+/** Cycles from the interrupt request to the first instruction of the
+    service routine, chosen so that the first TBR read in an ISR sees the
+    21-cycle offset that Glossy assumes. */
+#define SIM_IRQ_CYCLES          (21 - SIM_IO_CYCLES)
+/** Cycles to return from an interrupt service routine. */
+#define SIM_RETI_CYCLES         5
+/** Cycles the CPU is halted for each DMA transfer. */
+#define SIM_DMA_CYCLES          2
+/** Cycles needed to shift one byte on the SPI bus (UCLK = SMCLK / 2). */
+#define SIM_SPI_BYTE_CYCLES     16
+/** Cycles of the msp430-libc memcpy(): call and setup, then per byte
+    when source and destination have the same alignment (word loop) and
+    when they do not (byte loop). */
+#define SIM_MEMCPY_CYCLES       59
+#define SIM_MEMCPY_WORD_CYCLES  5
+#define SIM_MEMCPY_BYTE_CYCLES  13
+
+/*---------------------------------------------------------------------------*/
+struct sim_timer {
+  uint8_t ncc;               /**< Number of capture/compare blocks */
+  uint8_t ctl, r, cctl, ccr; /**< Register indexes (SIM_R16_...) */
+  uint8_t src;               /**< 0: stopped, 1: ACLK, 2: SMCLK (DCO) */
+  uint16_t base_val;         /**< Counter value at base_cnt */
+  uint64_t base_cnt;         /**< Source clock count at which base_val held */
+  uint64_t ev[7];            /**< Next compare/capture event, local cycles */
+  uint64_t ovf;              /**< Next overflow, local cycles */
+};
+
+struct sim_dma {
+  uintptr_t sa, da;          /**< Current addresses (host pointers) */
+  uint16_t sz;               /**< Transfers left in the block */
+};
+
+struct sim_frame {
+  int refs;
+  int src;                   /**< Index of the transmitting node */
+  uint8_t len;               /**< Value of the length field */
+  uint8_t cancelled;         /**< Transmission aborted before the preamble */
+  uint8_t truncated;         /**< Transmission aborted while on air */
+  uint8_t underflow;         /**< TXFIFO did not contain the whole frame */
+  uint8_t loaded;            /**< Bytes of data[] taken from the TXFIFO */
+  uint64_t t_sfd, t_end;     /**< Global time of SFD rise and fall */
+  uint8_t data[128];         /**< Length field and payload (no FCS) */
+};
+
+enum {
+  SIM_EV_TX_LOAD,
+  SIM_EV_TX_SFD,
+  SIM_EV_TX_END,
+  SIM_EV_RX_ARRIVAL,
+  SIM_EV_RX_END,
+};
+
+struct sim_event {
+  uint64_t cyc;              /**< Local cycle at which the event is due */
+  uint64_t t;                /**< Global time of the event */
+  uint64_t seq;              /**< Insertion order, breaks ties */
+  struct sim_frame *frame;
+  uint8_t type;
+};
+
+enum {
+  SIM_RADIO_OFF,
+  SIM_RADIO_IDLE,
+  SIM_RADIO_RX,
+  SIM_RADIO_TX_CAL,
+  SIM_RADIO_TX,
+};
+
+struct sim_radio {
+  uint8_t state;
+  uint8_t xosc;
+  uint16_t reg[0x40];
+  uint8_t txfifo[128];
+  uint8_t txfifo_len;
+  uint64_t rx_ready;         /**< Global time at which RX calibration ends */
+  /* Frame being received (or left in the RXFIFO). */
+  struct sim_frame *rx_frame;
+  uint64_t rx_start;
+  uint8_t rx_read, rx_done, rx_corrupt;
+  uint64_t rx_end;           /**< Local cycle of the last SFD fall in RX */
+  struct sim_frame **ci;     /**< Frames overlapping rx_frame within T_CI */
+  int nci, maxci;
+  /* Frame being transmitted. */
+  struct sim_frame *tx_frame;
+  uint8_t sfd;
+  /* SPI transaction. */
+  uint8_t cs, spi_idx, spi_cmd, spi_rx;
+  uint16_t spi_word;
+  int spi_pending;           /**< Byte being shifted out, -1 if none */
+  uint64_t spi_done;         /**< Local cycle at which it is complete */
+  /* Pending radio events, binary heap ordered by (cyc, seq). */
+  struct sim_event *ev;
+  int nev, maxev;
+  /* Statistics. */
+  uint64_t on_since, on_time;
+  uint32_t n_tx, n_rx_ok, n_rx_bad, n_collisions;
+  uint32_t relay_max;        /**< Longest delay from the end of a received
+                                  frame to the STXON that relays it, cycles.
+                                  The NOPs of timerb1_interrupt make it the
+                                  same on every node: it checks the
+                                  compensation, it does not time the code. */
+};
+
+struct sim_link {
+  int dst;
+  uint32_t prr;              /**< Packet reception ratio, 0..65536 */
+};
+
+struct sim_node {
+  int idx;                   /**< Position in the node array */
+  unsigned short id;         /**< Contiki node_id */
+  int32_t ppm;               /**< Clock drift */
+  uint64_t boot;             /**< Global time at which the node boots */
+  /* Execution context. */
+  uint8_t started, sleeping, halted;
+  ucontext_t uc;
+  jmp_buf ctx;
+  void *stack;
+  uint32_t heap;             /**< Bytes taken by malloc() in the firmware */
+  uint8_t *image;            /**< Saved firmware .data and .bss */
+  /* Local time. */
+  uint64_t cyc;              /**< Current local DCO cycle */
+  uint64_t limit;            /**< End of the current scheduling window */
+  uint64_t next_event;       /**< Earliest pending event, local cycles */
+  /* MCU. */
+  uint16_t r16[SIM_R16_NUM], w16[SIM_R16_WATCHED];
+  uint8_t r8[SIM_R8_NUM];
+  uint16_t sr;
+  uint16_t isr_sr[8];        /**< SR saved on interrupt entry */
+  int isr_depth;
+  uint32_t wakeups;          /**< Interrupts served in low-power mode */
+  uint64_t cpuoff;           /**< Cycles spent with the CPU off */
+  uint64_t isr_max;          /**< Longest service routine other than the
+                                  Glossy SFD one, cycles */
+  struct sim_timer ta, tb;
+  uint8_t fifop;             /**< Last sampled level of the FIFOP pin (P1.0) */
+  uint8_t spi_dma;           /**< Byte in the SPI shift register written by DMA */
+  int uart_pending;          /**< Byte in the USART1 shift register, -1 if none */
+  int uart_held;             /**< Byte held in TXBUF1 while UTXE1 is clear */
+  uint64_t uart_done;
+  uintptr_t dma_addr[3][2];  /**< DMAxSA and DMAxDA */
+  struct sim_dma dma[3];
+  /* Radio. */
+  struct sim_radio radio;
+  struct sim_link *links;
+  int nlinks;
+  /* Serial output. */
+  char line[256];
+  int line_len;
+  uint8_t in_slip;           /**< Inside a SLIP frame (not shown as text) */
+  int slip_len;
+  uint32_t uart_bytes;
+  uint32_t errors;           /**< Lines starting with "****" */
+  FILE *uart_log;            /**< Raw serial output, see option -u */
+  uint32_t rand_state;
+};
+
+extern struct sim_node *sim_nodes;
+extern int sim_num_nodes;
+extern struct sim_node *sim_cur;
+extern int sim_quiet;
+
+/* sim.c */
+uint64_t sim_node_time(const struct sim_node *n, uint64_t cyc);
+uint64_t sim_node_cycle(const struct sim_node *n, uint64_t t);
+void sim_yield(void);
+uint32_t sim_random(void);
+void sim_output(struct sim_node *n, uint8_t c);
+
+/* sim-mcu.c */
+void sim_mcu_init(struct sim_node *n);
+void sim_mcu_update_next_event(struct sim_node *n);
+void sim_mcu_sfd_edge(struct sim_node *n, uint64_t cyc, int rising);
+void sim_access(unsigned cycles);
+void sim_spi_wait(void);
+uint8_t sim_spi_rxbuf(void);
+void sim_spi_select(int on);
+int sim_spi_selected(void);
+
+/* sim-radio.c */
+void sim_radio_init(struct sim_node *n);
+void sim_radio_spi_byte(struct sim_node *n, uint8_t byte);
+void sim_radio_spi_select(struct sim_node *n, int on);
+int sim_radio_get_pin(const struct sim_node *n, int pin);
+int sim_radio_pin(int pin);
+void sim_radio_process(struct sim_node *n);
+uint64_t sim_radio_next_event(const struct sim_node *n);
+uint64_t sim_radio_fifop_rise(const struct sim_node *n);
+void sim_radio_finish(struct sim_node *n, uint64_t t);
+int sim_topology(const char *spec, double prr);
+
+#endif /* SIM_H_ */
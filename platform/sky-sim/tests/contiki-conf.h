@@ -0,0 +1,20 @@
+/*
+ * Configuration of the host builds of Contiki core modules in
+ * platform/sky-sim/tests (see Makefile).
+ */
+
+#ifndef CONTIKI_CONF_H_
+#define CONTIKI_CONF_H_
+
+typedef unsigned long clock_time_t;
+#define CLOCK_CONF_SECOND 128UL
+
+#define CCIF
+#define CLIF
+
+#define PROCESS_CONF_NUMEVENTS 128
+
+int splhigh(void);
+void splx(int s);
+
+#endif /* CONTIKI_CONF_H_ */
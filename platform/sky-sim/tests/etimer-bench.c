@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         Host benchmark of core/sys/etimer.c with many pending timers.
+ *
+ *         One process keeps n timers pending, re-arming each one with a
+ *         random interval of 1 to 500 ticks when it fires; every 8th
+ *         time it also stops another pending timer and sets it again. The clock
+ *         starts shortly before its wrap and advances one tick at a time,
+ *         with a jump of JUMP ticks every 50 ticks (as after a tickless
+ *         sleep); each step polls etimer_process and runs the processes
+ *         until they are idle. The time per tick and per fired timer is
+ *         printed for each n.
+ *
+ *         The run fails (exit status 1) if a timer fires before another
+ *         one with an earlier deadline, if a pending timer has expired
+ *         without firing, or if the next expiration time is after that
+ *         of a pending timer.
+ *
+ *         Usage:
+ *           make -C platform/sky-sim/tests check
+ *           platform/sky-sim/tests/etimer-bench 100 500 2000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sys/process.h"
+#include "sys/etimer.h"
+
+#define MAX_TIMERS   4096
+#define INTERVAL_MAX 500
+#define TICKS        2000
+#define JUMP         100
+
+/* clock.h has CLOCK_LT #if:ed out; the bench only compares nearby times. */
+#define BEFORE(a, b) ((long)((a) - (b)) < 0)
+
+static clock_time_t now;
+static struct etimer timers[MAX_TIMERS];
+static int n_timers;
+static unsigned long fired;
+static clock_time_t last_expiration;
+static int out_of_order;
+
+PROCESS(bench_process, "etimer benchmark");
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return now;
+}
+/*---------------------------------------------------------------------------*/
+int
+splhigh(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+splx(int s)
+{
+}
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+interval(void)
+{
+  return 1 + rand() % INTERVAL_MAX;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(bench_process, ev, data)
+{
+  static int i;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < n_timers; i++) {
+    etimer_set(&timers[i], interval());
+  }
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+    if(BEFORE(etimer_expiration_time(data), last_expiration)) {
+      out_of_order++;
+    }
+    last_expiration = etimer_expiration_time(data);
+    fired++;
+    etimer_set(data, interval());
+    /* Leave alone the timers whose event is still queued. */
+    i = rand() % n_timers;
+    if(fired % 8 == 0 && !etimer_expired(&timers[i])) {
+      etimer_stop(&timers[i]);
+      etimer_set(&timers[i], interval());
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+run(int n)
+{
+  struct timespec t0, t1;
+  double us;
+  clock_time_t next;
+  int i, ok;
+
+  n_timers = n;
+  fired = 0;
+  out_of_order = 0;
+  srand(1);
+  /* Cross the wrap of the clock during the run. */
+  now = (clock_time_t)0 - TICKS / 2;
+  last_expiration = now - INTERVAL_MAX;
+
+  process_init();
+  process_start(&etimer_process, NULL);
+  process_start(&bench_process, NULL);
+  while(process_run() > 0);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for(i = 0; i < TICKS; i++) {
+    now += i % 50 == 49 ? JUMP : 1;
+    etimer_request_poll();
+    while(process_run() > 0);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  us = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1e3;
+
+  ok = out_of_order == 0 && etimer_pending();
+  next = etimer_next_expiration_time();
+  for(i = 0; i < n; i++) {
+    if(BEFORE(etimer_expiration_time(&timers[i]), now + 1) ||
+       BEFORE(etimer_expiration_time(&timers[i]), next) ||
+       etimer_expired(&timers[i])) {
+      ok = 0;
+    }
+  }
+  printf("%5d timers: %7.2f us per tick, %6.3f us per fired timer, %7lu fired, %s\n",
+         n, us / TICKS, us / fired, fired, ok ? "ok" : "FAILED");
+
+  process_exit(&bench_process);
+  process_exit(&etimer_process);
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static const int defaults[] = { 100, 500, 2000 };
+  int i, n, ok = 1;
+
+  for(i = 1; i < argc || (argc == 1 && i <= 3); i++) {
+    n = argc > 1 ? atoi(argv[i]) : defaults[i - 1];
+    if(n < 1 || n > MAX_TIMERS) {
+      fprintf(stderr, "usage: %s [timers ...] (1 to %d timers)\n",
+              argv[0], MAX_TIMERS);
+      return 2;
+    }
+    ok &= run(n);
+  }
+  return ok ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
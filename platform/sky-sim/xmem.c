@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2011, ETH Zurich.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file
+ *         External flash of the sky-sim target. The only content is the
+ *         node id record read by node_id_restore(), which holds the id
+ *         assigned to the node by the simulator.
+ */
+
+#include <string.h>
+
+#include "contiki.h"
+#include "dev/xmem.h"
+
+/* Id of the node being executed, see sim.c. */
+unsigned short sim_node_id(void);
+
+/*---------------------------------------------------------------------------*/
+void
+xmem_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+int
+xmem_pread(void *_p, int size, unsigned long offset)
+{
+  unsigned char *p = _p;
+  unsigned short id = sim_node_id();
+  int i;
+
+  for(i = 0; i < size; i++, offset++) {
+    switch(offset - NODE_ID_XMEM_OFFSET) {
+    case 0:
+      p[i] = 0xad;
+      break;
+    case 1:
+      p[i] = 0xde;
+      break;
+    case 2:
+      p[i] = id >> 8;
+      break;
+    case 3:
+      p[i] = id & 0xff;
+      break;
+    default:
+      p[i] = 0;
+      break;
+    }
+  }
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+int
+xmem_pwrite(const void *_buf, int size, unsigned long addr)
+{
+  return size;
+}
+/*---------------------------------------------------------------------------*/
+int
+xmem_erase(long size, unsigned long addr)
+{
+  return size;
+}
+/*---------------------------------------------------------------------------*/
@@ -14,8 +14,23 @@
 
 #define ENERGEST_CONF_ON 1
 
+/* Never wait for the UART when logging: drop whole lines instead when
+   the transmit buffer is full (see uart1_tx_dropped()). The buffer is
+   drained by DMA channel 0, one interrupt per contiguous run instead of
+   one per byte. */
+#define UART1_CONF_TX_NONBLOCKING 1
+#define UART1_CONF_TX_BUFSIZE 512
+#define UART1_CONF_TX_WITH_DMA 1
+
+/* Serial input is handed to the main loop (see sys/deferred.h): the
+   receive interrupt only reads the byte, so that it never delays the
+   SFD capture of Glossy. */
+#define UART1_CONF_DEFER_INPUT 1
+
 #define HAVE_STDINT_H
 #define MSP430_MEMCPY_WORKAROUND 1
+/* Paint the free RAM at boot to track the stack high-watermark. */
+#define MSP430_CONF_STACK_PAINT 1
 #include "msp430def.h"
 
 #define CCIF
@@ -23,6 +38,8 @@
 
 #define PROCESS_CONF_NUMEVENTS 8
 #define PROCESS_CONF_STATS 1
+#define PROCESS_CONF_COALESCE 1
+#define PROCESS_CONF_PROFILE 1
 
 /* CPU target speed in Hz */
 #if COOJA
@@ -34,6 +51,21 @@
 /* Our clock resolution, this is the same as Unix HZ. */
 #define CLOCK_CONF_SECOND 128UL
 
+/* Wake up for the next etimer rather than at every clock tick. */
+#define CLOCK_CONF_TICKLESS 1
+
+/* Sleep in LPM0 rather than busy-wait during Glossy phases. */
+#define GLOSSY_CONF_LPM 1
+
+/* Read received packets in chunks of 4 bytes on FIFOP interrupts. */
+#define GLOSSY_CONF_RX_CHUNK 4
+
+/* Copy received packets to the TXFIFO by DMA when relaying them. */
+#define GLOSSY_CONF_TX_DMA 1
+
+/* Measure the constant part of the Glossy SFD interrupt delay at startup. */
+#define GLOSSY_CONF_CALIBRATE_IRQ 1
+
 #define BAUD2UBR(baud) ((F_CPU/baud))
 
 /*
@@ -72,6 +104,17 @@ typedef unsigned long off_t;
 				/* USART0 Tx buffer ready? */
 #define SPI_WAITFORTxREADY() while ((IFG1 & UTXIFG0) == 0)
 
+/* DMA channel 1 feeds SPI_TXBUF on UTXIFG0 (see FASTSPI_WRITE_FIFO_DMA);
+   channel 0 is left to the UART. */
+#define SPI_DMA_WRITE(p,c) do {\
+  DMACTL0 = (DMACTL0 & ~DMA1TSEL_15) | DMA1TSEL_4;\
+  DMA1SA = (uintptr_t)(p);\
+  DMA1DA = (uintptr_t)&SPI_TXBUF;\
+  DMA1SZ = (c);\
+  DMA1CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0 | DMASBDB | DMAEN;\
+} while (0)
+#define SPI_DMA_BUSY() (DMA1CTL & DMAEN)
+
 #define SCK            1  /* P3.1 - Output: SPI Serial Clock (SCLK) */
 #define MOSI           2  /* P3.2 - Output: SPI Master out - slave in (MOSI) */
 #define MISO           3  /* P3.3 - Input:  SPI Master in - slave out (MISO) */
@@ -76,6 +76,7 @@ main(int argc, char **argv)
   leds_init();
   leds_on(LEDS_RED);
 
+  deferred_init(); /* Must come before the first interrupt handler runs */
   uart1_init(BAUD2UBR(115200)); /* Must come before first printf */
 
   leds_on(LEDS_GREEN);
@@ -131,7 +132,9 @@ main(int argc, char **argv)
     do {
       /* Reset watchdog. */
       watchdog_periodic();
-      r = process_run();
+      /* Work handed over by interrupt handlers runs before processes. */
+      r = deferred_run();
+      r += process_run();
     } while(r > 0);
 
     /*
@@ -139,7 +142,7 @@ main(int argc, char **argv)
      */
     int s = splhigh();		/* Disable interrupts. */
     /* uart1_active is for avoiding LPM3 when still sending or receiving */
-    if(process_nevents() != 0 || uart1_active()) {
+    if(process_nevents() != 0 || deferred_pending() || uart1_active()) {
       splx(s);			/* Re-enable interrupts. */
     } else {
       static unsigned long irq_energest = 0;
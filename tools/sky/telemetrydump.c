@@ -0,0 +1,245 @@
+/*
+ * Decoder for the Glossy telemetry records of core/dev/glossy-telemetry.h.
+ *
+ * Reads the raw serial output of a node from a serial device, a file or
+ * standard input, prints text lines unchanged and each telemetry record
+ * as one line of text:
+ *
+ *   cc -o telemetrydump telemetrydump.c
+ *   ./telemetrydump -b115200 /dev/ttyUSB0
+ *   ./glossy-test-hda.sky-sim -u node -d 60 -q; ./telemetrydump node6
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+#define TELEMETRY_TYPE 0x47
+#define TELEMETRY_LEN  29
+#define TELEMETRY_MISSED 0xffffffffUL
+
+#define PROFILE_TYPE    0x50
+#define PROFILE_LEN_MIN 11
+
+#define MEMORY_TYPE    0x4d
+#define MEMORY_LEN     9
+
+#define RTIMER_SECOND  32768
+
+static unsigned char rxbuf[256];
+
+static int
+usage(int result)
+{
+  printf("Usage: telemetrydump [-bSPEED] [-n] [SERIALDEVICE|FILE]\n");
+  printf("       reads standard input if no device or file is given\n");
+  printf("       -n to hide text lines\n");
+  return result;
+}
+
+static unsigned short
+crc_byte(unsigned short crc, unsigned char b)
+{
+  crc = (unsigned char)(crc >> 8) | (crc << 8);
+  crc ^= b;
+  crc ^= (unsigned char)(crc & 0xff) >> 4;
+  crc ^= crc << 12;
+  crc ^= (crc & 0xff) << 5;
+  return crc;
+}
+
+static unsigned
+get16(const unsigned char *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static unsigned long
+get32(const unsigned char *p)
+{
+  return get16(p) | ((unsigned long)get16(&p[2]) << 16);
+}
+
+static int
+check_crc(const unsigned char *p, int len)
+{
+  unsigned short crc = 0;
+  int i;
+
+  for(i = 0; i < len - 2; i++) {
+    crc = crc_byte(crc, p[i]);
+  }
+  if(crc != get16(&p[len - 2])) {
+    fprintf(stderr, "**** bad CRC\n");
+    return 0;
+  }
+  return 1;
+}
+
+static void
+print_profile(const unsigned char *p, int len)
+{
+  unsigned long ticks;
+
+  ticks = get32(&p[3]);
+  printf("profile '%.*s': %u calls, %.3f ms total, %.3f ms max\n",
+         len - PROFILE_LEN_MIN, (const char *)&p[9], get16(&p[1]),
+         ticks * 1000.0 / RTIMER_SECOND,
+         get16(&p[7]) * 1000.0 / RTIMER_SECOND);
+}
+
+static void
+print_record(const unsigned char *p, int len)
+{
+  unsigned long seq_no, cpu, lpm, listen, transmit;
+
+  if(len >= PROFILE_LEN_MIN && p[0] == PROFILE_TYPE) {
+    if(check_crc(p, len)) {
+      print_profile(p, len);
+    }
+    return;
+  }
+  if(len == MEMORY_LEN && p[0] == MEMORY_TYPE) {
+    if(check_crc(p, len)) {
+      printf("memory: stack max %u B, margin %u B, heap %u B\n",
+             get16(&p[1]), get16(&p[3]), get16(&p[5]));
+    }
+    return;
+  }
+  if(len != TELEMETRY_LEN || p[0] != TELEMETRY_TYPE) {
+    fprintf(stderr, "**** unknown record (%d bytes)\n", len);
+    return;
+  }
+  if(!check_crc(p, len)) {
+    return;
+  }
+  seq_no = get32(&p[1]);
+  cpu = get32(&p[11]);
+  lpm = get32(&p[15]);
+  listen = get32(&p[19]);
+  transmit = get32(&p[23]);
+  if(seq_no == TELEMETRY_MISSED) {
+    printf("seq_no -, ");
+  } else {
+    printf("seq_no %lu, ", seq_no);
+  }
+  printf("rx_cnt %u, relay_cnt %u, T_slot_h %u, "
+         "latency %.3f ms, cpu %lu, lpm %lu, listen %lu, transmit %lu",
+         p[5], p[6], get16(&p[7]),
+         get16(&p[9]) * 1000.0 / RTIMER_SECOND,
+         cpu, lpm, listen, transmit);
+  if(cpu + lpm > 0) {
+    printf(", radio-on %.3f %%", 100.0 * (listen + transmit) / (cpu + lpm));
+  }
+  printf("\n");
+}
+
+int
+main(int argc, char **argv)
+{
+  struct termios options;
+  speed_t speed = 0;
+  const char *device = NULL;
+  unsigned char buf[64];
+  int fd = 0, hide_text = 0, in_frame = 0, esc = 0, index = 0;
+  int i, n;
+
+  for(i = 1; i < argc; i++) {
+    if(argv[i][0] == '-' && argv[i][1] != '\0') {
+      switch(argv[i][1]) {
+      case 'b':
+        if(strcmp(&argv[i][2], "57600") == 0) {
+          speed = B57600;
+        } else if(strcmp(&argv[i][2], "115200") == 0) {
+          speed = B115200;
+        } else {
+          fprintf(stderr, "unsupported speed: %s\n", &argv[i][2]);
+          return usage(1);
+        }
+        break;
+      case 'n':
+        hide_text = 1;
+        break;
+      case 'h':
+        return usage(0);
+      default:
+        fprintf(stderr, "unknown option '%c'\n", argv[i][1]);
+        return usage(1);
+      }
+    } else if(device == NULL) {
+      device = argv[i];
+    } else {
+      fprintf(stderr, "too many arguments\n");
+      return usage(1);
+    }
+  }
+
+  if(device != NULL && strcmp(device, "-") != 0) {
+    fd = open(device, O_RDONLY | O_NOCTTY);
+    if(fd < 0) {
+      perror(device);
+      return 1;
+    }
+  }
+  if(isatty(fd)) {
+    if(tcgetattr(fd, &options) < 0) {
+      perror("could not get options");
+      return 1;
+    }
+    cfmakeraw(&options);
+    options.c_cflag |= CLOCAL | CREAD;
+    if(speed != 0) {
+      cfsetispeed(&options, speed);
+      cfsetospeed(&options, speed);
+    }
+    if(tcsetattr(fd, TCSANOW, &options) < 0) {
+      perror("could not set options");
+      return 1;
+    }
+  }
+
+  while((n = read(fd, buf, sizeof(buf))) > 0) {
+    for(i = 0; i < n; i++) {
+      unsigned char c = buf[i];
+
+      if(c == SLIP_END) {
+        if(in_frame && index > 0) {
+          print_record(rxbuf, index);
+          in_frame = 0;
+        } else {
+          in_frame = 1;
+        }
+        index = 0;
+        esc = 0;
+      } else if(in_frame) {
+        if(c == SLIP_ESC) {
+          esc = 1;
+          continue;
+        }
+        if(esc) {
+          c = c == SLIP_ESC_END ? SLIP_END : c == SLIP_ESC_ESC ? SLIP_ESC : c;
+          esc = 0;
+        }
+        if(index < sizeof(rxbuf)) {
+          rxbuf[index++] = c;
+        }
+      } else if(!hide_text) {
+        putchar(c);
+      }
+    }
+    fflush(stdout);
+  }
+  if(n < 0) {
+    perror("could not read");
+    return 1;
+  }
+  return 0;
+}